@@ -0,0 +1,250 @@
+#include "AsciiArt.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define ASCII_ART_SSE2 1
+#include <emmintrin.h>
+#else
+#define ASCII_ART_SSE2 0
+#endif
+
+
+namespace
+{
+
+// Darkest to brightest, the same ramp as the shipped portraits
+const char luminanceRamp[] = " .,-;=+x";
+constexpr int rampSize = sizeof(luminanceRamp) - 1;
+
+
+// Reads the next header number, skipping white space and comments
+bool ReadHeaderValue(const char*& p, const char* end, int& value)
+{
+	for (;;)
+	{
+		while (p < end && isspace((uchar)*p))
+		{
+			++p;
+		}
+		if (p < end && *p == '#')
+		{
+			while (p < end && *p != '\n')
+			{
+				++p;
+			}
+			continue;
+		}
+		break;
+	}
+	if (p == end || !isdigit((uchar)*p))
+	{
+		return false;
+	}
+	value = 0;
+	while (p < end && isdigit((uchar)*p))
+	{
+		value = value * 10 + (*p++ - '0');
+		if (value > (1 << 20))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Rounded average, same as _mm_avg_epu8
+inline uint8 Avg(uint8 a, uint8 b)
+{
+	return (uint8)((a + b + 1) >> 1);
+}
+
+
+// Box filter of the rows [y0, y1) and columns [x0, x1) of image
+uint8 AverageRect(const GrayImage& image, int x0, int x1, int y0, int y1)
+{
+	uint32 sum = 0;
+	for (int y = y0; y < y1; ++y)
+	{
+		const uint8* row = image.pixels.data() + y * image.width;
+		for (int x = x0; x < x1; ++x)
+		{
+			sum += row[x];
+		}
+	}
+	return (uint8)(sum / ((x1 - x0) * (y1 - y0)));
+}
+
+}
+
+
+bool LoadPNM(GrayImage& image, const char* fileName)
+{
+	MappedFile file;
+	if (!file.Open(fileName))
+	{
+		return false;
+	}
+	const char* p = static_cast<const char*>(file.GetData());
+	const char* end = p + file.GetSize();
+	if (file.GetSize() < 2 || p[0] != 'P' || (p[1] != '5' && p[1] != '6'))
+	{
+		return false;
+	}
+	const int channels = (p[1] == '6') ? 3 : 1;
+	p += 2;
+	int width, height, maxValue;
+	if (!ReadHeaderValue(p, end, width) || !ReadHeaderValue(p, end, height) || !ReadHeaderValue(p, end, maxValue)
+		|| width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 255 || p == end)
+	{
+		return false;
+	}
+	++p; // single white space before the pixels
+	const size_t numPixels = (size_t)width * height;
+	if ((size_t)(end - p) < numPixels * channels)
+	{
+		return false;
+	}
+	image.width = width;
+	image.height = height;
+	image.pixels.resize(numPixels);
+	const uint8* src = reinterpret_cast<const uint8*>(p);
+	for (size_t i = 0; i < numPixels; ++i, src += channels)
+	{
+		// Rec. 601 luma
+		const uint32 l = (channels == 1) ? src[0] : (77 * src[0] + 150 * src[1] + 29 * src[2]) >> 8;
+		image.pixels[i] = (uint8)(maxValue == 255 ? l : l * 255 / maxValue);
+	}
+	return true;
+}
+
+
+void BoxDownsample(const GrayImage& src, GrayImage& dst)
+{
+	assert(&src != &dst);
+	dst.width = src.width / 2;
+	dst.height = src.height / 2;
+	dst.pixels.resize((size_t)dst.width * dst.height);
+	for (int y = 0; y < dst.height; ++y)
+	{
+		const uint8* r0 = src.pixels.data() + (2 * y) * src.width;
+		const uint8* r1 = r0 + src.width;
+		uint8* out = dst.pixels.data() + y * dst.width;
+		int x = 0;
+#if ASCII_ART_SSE2
+		// 32 source pixels of each row give 16 destination pixels: average the rows, then the even and
+		// odd pixels as 16 bit lanes
+		const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+		for (; x + 16 <= dst.width; x += 16)
+		{
+			const __m128i v0 = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0 + 2 * x)), _mm_loadu_si128((const __m128i*)(r1 + 2 * x)));
+			const __m128i v1 = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(r0 + 2 * x + 16)), _mm_loadu_si128((const __m128i*)(r1 + 2 * x + 16)));
+			const __m128i h0 = _mm_avg_epu16(_mm_and_si128(v0, lowBytes), _mm_srli_epi16(v0, 8));
+			const __m128i h1 = _mm_avg_epu16(_mm_and_si128(v1, lowBytes), _mm_srli_epi16(v1, 8));
+			_mm_storeu_si128((__m128i*)(out + x), _mm_packus_epi16(h0, h1));
+		}
+#endif
+		for (; x < dst.width; ++x)
+		{
+			out[x] = Avg(Avg(r0[2 * x], r1[2 * x]), Avg(r0[2 * x + 1], r1[2 * x + 1]));
+		}
+	}
+}
+
+
+void AsciiPyramid::Build(const GrayImage& image, int maxWidth, int minWidth)
+{
+	assert(maxWidth > 0 && minWidth > 0);
+	Clear();
+	if (image.width <= 0 || image.height <= 0)
+	{
+		return;
+	}
+	// Mip chain of the picture, each level of the pyramid is sampled from the smallest mip that still
+	// has at least one pixel per glyph, so the final box filter is at most 2 pixels wide
+	std::vector<GrayImage> mips(1, image);
+	for (int width = std::min(maxWidth, image.width); width >= minWidth; width /= 2)
+	{
+		const int height = std::max(1, (width * image.height + image.width) / (2 * image.width)); // cells are twice as tall as wide
+		for (;;)
+		{
+			const GrayImage& last = mips.back();
+			if (last.width / 2 < width || last.height / 2 < height)
+			{
+				break;
+			}
+			GrayImage half;
+			BoxDownsample(last, half);
+			mips.push_back(std::move(half));
+		}
+		const GrayImage* mip = &mips[0];
+		for (const auto& m : mips)
+		{
+			if (m.width >= width && m.height >= height)
+			{
+				mip = &m;
+			}
+		}
+
+		Level level;
+		level.img.reserve(1 + (size_t)height * (width + 1) + 1);
+		level.img.push_back(L'\n');
+		for (int y = 0; y < height; ++y)
+		{
+			const int y0 = y * mip->height / height;
+			const int y1 = std::max(y0 + 1, (y + 1) * mip->height / height);
+			for (int x = 0; x < width; ++x)
+			{
+				const int x0 = x * mip->width / width;
+				const int x1 = std::max(x0 + 1, (x + 1) * mip->width / width);
+				const uint8 l = AverageRect(*mip, x0, x1, y0, y1);
+				level.img.push_back((wchar_t)luminanceRamp[l * rampSize / 256]);
+			}
+			level.img.push_back(L'\n');
+		}
+		level.img.push_back(0);
+		level.image = { nullptr, nullptr, width, height };
+		levels.push_back(std::move(level));
+	}
+	// Point the images at their glyphs once the vector does not move anymore
+	for (auto& level : levels)
+	{
+		level.image.img = level.img.data();
+	}
+}
+
+
+void AsciiPyramid::Clear()
+{
+	levels.clear();
+}
+
+
+int AsciiPyramid::GetNumLevels() const
+{
+	return (int)levels.size();
+}
+
+
+const Image& AsciiPyramid::GetLevel(int level) const
+{
+	assert(level >= 0 && level < GetNumLevels());
+	return levels[level].image;
+}
+
+
+int AsciiPyramid::SelectLevel(int cols, int rows) const
+{
+	for (int i = 0; i < GetNumLevels(); ++i)
+	{
+		if (levels[i].image.width <= cols && levels[i].image.height <= rows)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
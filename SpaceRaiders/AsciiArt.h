@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Base.h"
+#include "Image.h"
+#include <vector>
+
+
+// 8 bit grayscale image
+struct GrayImage
+{
+	std::vector<uint8> pixels;
+	int                width = 0;
+	int                height = 0;
+};
+
+// Binary PGM (P5) or PPM (P6) file, colors are converted to luminance
+bool LoadPNM(GrayImage& image, const char* fileName);
+// Halves both dimensions averaging 2x2 blocks, odd last rows and columns are dropped
+void BoxDownsample(const GrayImage& src, GrayImage& dst);
+
+
+// ASCII art of one image at several widths. Level 0 is the widest, each next level is half as wide.
+// Glyphs are chosen by luminance, a cell covers twice as many pixel rows as columns to keep the
+// aspect of the picture on a console
+class AsciiPyramid
+{
+public:
+
+	// maxWidth: width in glyphs of level 0
+	void Build(const GrayImage& image, int maxWidth, int minWidth = 8);
+	void Clear();
+
+	int GetNumLevels() const;
+	const Image& GetLevel(int level) const;
+	// Widest level that fits in cols x rows, -1 if none
+	int SelectLevel(int cols, int rows) const;
+
+private:
+
+	struct Level
+	{
+		std::vector<wchar_t> img; // same layout as the image literals
+		Image                image;
+	};
+	std::vector<Level> levels;
+};
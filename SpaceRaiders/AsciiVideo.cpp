@@ -0,0 +1,483 @@
+#include "AsciiVideo.h"
+#include "AssetPack.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+namespace
+{
+
+constexpr uint32 asciiVideoMagic = 0x56415253; // "SRAV"
+constexpr uint32 asciiVideoVersion = 1;
+constexpr int    maxRunLength = 0xFFFF;
+// Shorter runs of identical cells are cheaper as literals
+constexpr int    minRepeatLength = 3;
+// The prefetch thread reads one byte of each page
+constexpr uint32 pageSize = 4096;
+
+const CharInfo blankCell = { ' ', 0 };
+
+
+bool SameCell(const CharInfo& a, const CharInfo& b)
+{
+	return a.ch == b.ch && a.attributes == b.attributes;
+}
+
+}
+
+
+AsciiVideoWriter::AsciiVideoWriter() :
+	file { nullptr },
+	failed { false }
+{
+	memset(&header, 0, sizeof(header));
+}
+
+
+AsciiVideoWriter::~AsciiVideoWriter()
+{
+	Close();
+}
+
+
+bool AsciiVideoWriter::Open(const char* fileName, int cols, int rows, float frameRate)
+{
+	assert(cols > 0 && rows > 0);
+	assert(frameRate > 0.f);
+	Close();
+	file = fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	header.magic = asciiVideoMagic;
+	header.version = asciiVideoVersion;
+	header.cols = cols;
+	header.rows = rows;
+	header.numFrames = 0;
+	header.frameRate = frameRate;
+	header.indexOffset = 0;
+	prevFrame.assign((size_t)cols * rows, blankCell);
+	offsets.assign(1, (uint32)sizeof(AsciiVideoHeader));
+	failed = fwrite(&header, sizeof(header), 1, file) != 1; // written again by Close
+	return !failed;
+}
+
+
+bool AsciiVideoWriter::AddFrame(const CharInfo* frame)
+{
+	assert(file);
+	const int numCells = header.cols * header.rows;
+	encoded.clear();
+	uint32 skip = 0;
+	for (int i = 0; i < numCells; )
+	{
+		if (SameCell(frame[i], prevFrame[i]))
+		{
+			++skip;
+			++i;
+			continue;
+		}
+		// Changed cells, either a run of the same cell or literal cells up to the next unchanged cell
+		// or the next repeated run
+		int n = 1;
+		while (i + n < numCells && n < maxRunLength && SameCell(frame[i + n], frame[i]) && !SameCell(frame[i + n], prevFrame[i + n]))
+		{
+			++n;
+		}
+		const bool repeat = n >= minRepeatLength;
+		if (!repeat)
+		{
+			n = 1;
+			while (i + n < numCells && n < maxRunLength && !SameCell(frame[i + n], prevFrame[i + n]))
+			{
+				if (i + n + 2 < numCells && SameCell(frame[i + n], frame[i + n + 1]) && SameCell(frame[i + n], frame[i + n + 2])
+					&& !SameCell(frame[i + n + 1], prevFrame[i + n + 1]) && !SameCell(frame[i + n + 2], prevFrame[i + n + 2]))
+				{
+					break;
+				}
+				++n;
+			}
+		}
+		WriteRun(skip, frame + i, n, repeat);
+		skip = 0;
+		i += n;
+	}
+	std::copy(frame, frame + numCells, prevFrame.begin());
+
+	if (!encoded.empty() && fwrite(encoded.data(), encoded.size(), 1, file) != 1)
+	{
+		failed = true;
+	}
+	offsets.push_back(offsets.back() + (uint32)encoded.size());
+	++header.numFrames;
+	return !failed;
+}
+
+
+bool AsciiVideoWriter::Close()
+{
+	if (!file)
+	{
+		return false;
+	}
+	header.indexOffset = offsets.back();
+	if (fwrite(offsets.data(), sizeof(uint32), offsets.size(), file) != offsets.size()
+		|| fseek(file, 0, SEEK_SET) != 0
+		|| fwrite(&header, sizeof(header), 1, file) != 1)
+	{
+		failed = true;
+	}
+	if (fclose(file) != 0)
+	{
+		failed = true;
+	}
+	file = nullptr;
+	return !failed;
+}
+
+
+void AsciiVideoWriter::WriteRun(uint32 skip, const CharInfo* cells, int count, bool repeat)
+{
+	const AsciiVideoRun run = { skip, (uint16)count, (uint16)(repeat ? 1 : 0) };
+	const size_t cellsSize = (repeat ? 1 : count) * sizeof(CharInfo);
+	const size_t size = encoded.size();
+	encoded.resize(size + sizeof(run) + cellsSize);
+	memcpy(&encoded[size], &run, sizeof(run));
+	memcpy(&encoded[size + sizeof(run)], cells, cellsSize);
+}
+
+
+AsciiVideo::AsciiVideo() :
+	header { nullptr },
+	index { nullptr },
+	frameIndex { -1 },
+	time { 0.f },
+	changedCells { 0 },
+	prefetchFrames { 0 },
+	playhead { -1 },
+	quit { false }
+{}
+
+
+AsciiVideo::~AsciiVideo()
+{
+	Close();
+}
+
+
+bool AsciiVideo::Open(const char* fileName, int prefetchFrames_)
+{
+	assert(prefetchFrames_ >= 0);
+	Close();
+	if (!file.Open(fileName))
+	{
+		return false;
+	}
+	const byte* data = static_cast<const byte*>(file.GetData());
+	const size_t size = file.GetSize();
+	const AsciiVideoHeader* h = reinterpret_cast<const AsciiVideoHeader*>(data);
+	bool valid = size >= sizeof(AsciiVideoHeader) && h->magic == asciiVideoMagic && h->version == asciiVideoVersion
+		&& h->cols > 0 && h->rows > 0 && h->cols <= 4096 && h->rows <= 4096 && h->numFrames > 0 && h->frameRate > 0.f
+		&& h->indexOffset % sizeof(uint32) == 0 && h->indexOffset <= size
+		&& (size - h->indexOffset) / sizeof(uint32) >= (size_t)h->numFrames + 1;
+	if (valid)
+	{
+		// Frames must be in order and end before the index
+		const uint32* offsets = reinterpret_cast<const uint32*>(data + h->indexOffset);
+		valid = offsets[0] >= sizeof(AsciiVideoHeader);
+		for (uint32 i = 0; valid && i < h->numFrames; ++i)
+		{
+			valid = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= h->indexOffset;
+		}
+	}
+	if (!valid)
+	{
+		file.Close();
+		return false;
+	}
+	header = h;
+	index = reinterpret_cast<const uint32*>(data + h->indexOffset);
+	frame.resize((size_t)header->cols * header->rows);
+	prefetchFrames = prefetchFrames_;
+	Rewind();
+	if (prefetchFrames > 0)
+	{
+		quit = false;
+		prefetchThread = std::thread(&AsciiVideo::PrefetchLoop, this);
+	}
+	return true;
+}
+
+
+void AsciiVideo::Close()
+{
+	if (prefetchThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		cv.notify_one();
+		prefetchThread.join();
+	}
+	file.Close();
+	header = nullptr;
+	index = nullptr;
+	frame.clear();
+	frameIndex = -1;
+}
+
+
+bool AsciiVideo::IsOpen() const
+{
+	return header != nullptr;
+}
+
+
+bool AsciiVideo::Update(float dt, bool loop)
+{
+	changedCells = 0;
+	if (!header)
+	{
+		return false;
+	}
+	const int numFrames = (int)header->numFrames;
+	time += dt;
+	int target = (int)(time * header->frameRate);
+	if (target >= numFrames)
+	{
+		if (loop)
+		{
+			// Start over from a blank frame
+			time = fmodf(time, numFrames / header->frameRate);
+			target = std::min((int)(time * header->frameRate), numFrames - 1);
+			ClearFrame();
+		}
+		else
+		{
+			target = numFrames - 1;
+		}
+	}
+	if (target == frameIndex)
+	{
+		return false;
+	}
+	// Deltas are applied in order, a late frame decodes all the frames it skipped
+	while (frameIndex < target)
+	{
+		changedCells += DecodeFrame(++frameIndex);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		playhead = frameIndex;
+	}
+	cv.notify_one();
+	return true;
+}
+
+
+void AsciiVideo::Rewind()
+{
+	time = 0.f;
+	ClearFrame();
+}
+
+
+bool AsciiVideo::IsFinished() const
+{
+	return header && frameIndex == (int)header->numFrames - 1;
+}
+
+
+float AsciiVideo::GetTimeToNextFrame(bool loop) const
+{
+	if (!header)
+	{
+		return FLT_MAX;
+	}
+	// After the last frame a looping video starts over at numFrames / frameRate
+	const int next = (int)(time * header->frameRate) + 1;
+	if (next >= (int)header->numFrames && !loop)
+	{
+		return FLT_MAX;
+	}
+	return std::max(0.f, next / header->frameRate - time);
+}
+
+
+const CharInfo* AsciiVideo::GetFrame() const
+{
+	return frame.data();
+}
+
+
+int AsciiVideo::GetCols() const
+{
+	return header ? header->cols : 0;
+}
+
+
+int AsciiVideo::GetRows() const
+{
+	return header ? header->rows : 0;
+}
+
+
+int AsciiVideo::GetFrameIndex() const
+{
+	return frameIndex;
+}
+
+
+int AsciiVideo::GetNumFrames() const
+{
+	return header ? (int)header->numFrames : 0;
+}
+
+
+int AsciiVideo::GetChangedCells() const
+{
+	return changedCells;
+}
+
+
+void AsciiVideo::ClearFrame()
+{
+	std::fill(frame.begin(), frame.end(), blankCell);
+	frameIndex = -1;
+}
+
+
+int AsciiVideo::DecodeFrame(int frameNumber)
+{
+	assert(frameNumber >= 0 && frameNumber < (int)header->numFrames);
+	const byte* data = static_cast<const byte*>(file.GetData());
+	const byte* p = data + index[frameNumber];
+	const byte* end = data + index[frameNumber + 1];
+	CharInfo* dst = frame.data();
+	const CharInfo* dstEnd = dst + frame.size();
+	int numChanged = 0;
+	while ((size_t)(end - p) >= sizeof(AsciiVideoRun))
+	{
+		AsciiVideoRun run;
+		memcpy(&run, p, sizeof(run));
+		p += sizeof(run);
+		const size_t cellsSize = (run.repeat ? 1 : run.count) * sizeof(CharInfo);
+		if (run.skip > (size_t)(dstEnd - dst) || run.count > (size_t)(dstEnd - dst) - run.skip || cellsSize > (size_t)(end - p))
+		{
+			assert(false && "Corrupt video frame");
+			break;
+		}
+		dst += run.skip;
+		if (run.repeat)
+		{
+			CharInfo cell;
+			memcpy(&cell, p, sizeof(cell));
+			std::fill(dst, dst + run.count, cell);
+		}
+		else
+		{
+			memcpy(dst, p, cellsSize);
+		}
+		dst += run.count;
+		p += cellsSize;
+		numChanged += run.count;
+	}
+	return numChanged;
+}
+
+
+void AsciiVideo::PrefetchLoop()
+{
+	const byte* data = static_cast<const byte*>(file.GetData());
+	const int numFrames = (int)header->numFrames;
+	volatile byte sink = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!quit)
+	{
+		const int current = playhead;
+		lock.unlock();
+		// Pages already resident cost one read, only the pages not yet read fault
+		byte sum = 0;
+		for (int i = 1; i <= std::min(prefetchFrames, numFrames); ++i)
+		{
+			const int f = (current + i + numFrames) % numFrames; // wraps around for looping videos
+			for (uint32 offset = index[f]; offset < index[f + 1]; offset += pageSize)
+			{
+				sum += data[offset];
+			}
+		}
+		sink = sum;
+		lock.lock();
+		cv.wait(lock, [this, current] { return quit || playhead != current; });
+	}
+}
+
+
+int RunVideoEncoder(const char* fileName, float frameRate, int numArgs, char* args[])
+{
+	if (numArgs <= 0 || frameRate <= 0.f)
+	{
+		fprintf(stderr, "Expected a frame rate and glyphs.txt[,colors.txt] files\n");
+		return 1;
+	}
+	std::vector<TextImage> images(numArgs);
+	int cols = 0;
+	int rows = 0;
+	for (int i = 0; i < numArgs; ++i)
+	{
+		char* glyphFile = args[i];
+		char* colorFile = strchr(glyphFile, ',');
+		if (colorFile)
+		{
+			*colorFile++ = 0;
+		}
+		if (!LoadTextImage(images[i], glyphFile, colorFile))
+		{
+			fprintf(stderr, "Can't load %s\n", glyphFile);
+			return 1;
+		}
+		cols = std::max(cols, images[i].width);
+		rows = std::max(rows, images[i].height);
+	}
+
+	AsciiVideoWriter writer;
+	if (!writer.Open(fileName, cols, rows, frameRate))
+	{
+		fprintf(stderr, "Can't write %s\n", fileName);
+		return 1;
+	}
+	const uint16 white = GetColorAttributes(Color::white);
+	std::vector<CharInfo> canvas((size_t)cols * rows);
+	for (const TextImage& image : images)
+	{
+		std::fill(canvas.begin(), canvas.end(), blankCell);
+		const int x0 = (cols - image.width) / 2;
+		const int y0 = (rows - image.height) / 2;
+		for (int y = 0; y < image.height; ++y)
+		{
+			for (int x = 0; x < image.width; ++x)
+			{
+				const int s = x + y * (image.width + 1) + 1;
+				if (image.img[s] != ' ')
+				{
+					CharInfo& c = canvas[(y0 + y) * cols + x0 + x];
+					c.ch = (uint16)image.img[s];
+					c.attributes = image.colors.empty() ? white : GetColorAttributes((Color)(image.colors[s] - '0'));
+				}
+			}
+		}
+		writer.AddFrame(canvas.data());
+	}
+	if (!writer.Close())
+	{
+		fprintf(stderr, "Can't write %s\n", fileName);
+		return 1;
+	}
+	printf("%s: %d frames of %dx%d\n", fileName, numArgs, cols, rows);
+	return 0;
+}
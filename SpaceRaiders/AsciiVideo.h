@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Base.h"
+#include "CharInfo.h"
+#include "MappedFile.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+
+// ASCII video file. A header, the frames and an index of the frame offsets. Each frame is a list of
+// runs of cells that changed since the previous frame (the first one since a blank frame), so a
+// frame costs only its changed cells both on disk and to decode
+struct AsciiVideoHeader
+{
+	uint32 magic;
+	uint32 version;
+	int32  cols;
+	int32  rows;
+	uint32 numFrames;
+	float  frameRate;
+	uint32 indexOffset; // numFrames + 1 uint32 offsets, the last one is the end of the last frame
+};
+
+// Skips skip unchanged cells then writes count cells. A repeated run is followed by one cell, a
+// literal run by count cells
+struct AsciiVideoRun
+{
+	uint32 skip;
+	uint16 count;
+	uint16 repeat;
+};
+
+
+class AsciiVideoWriter
+{
+public:
+
+	AsciiVideoWriter();
+	~AsciiVideoWriter();
+
+	bool Open(const char* fileName, int cols, int rows, float frameRate);
+	// frame: cols * rows cells
+	bool AddFrame(const CharInfo* frame);
+	// Writes the index, returns false if any write failed
+	bool Close();
+
+private:
+
+	void WriteRun(uint32 skip, const CharInfo* cells, int count, bool repeat);
+
+	FILE*                 file;
+	AsciiVideoHeader      header;
+	std::vector<CharInfo> prevFrame;
+	std::vector<uint32>   offsets;
+	std::vector<byte>     encoded; // current frame, reused to avoid allocations
+	bool                  failed;
+};
+
+
+// Plays a video file mapped in memory. Frames are decoded in place into the current frame as the
+// playback time reaches them. A prefetch thread touches the pages of the next frames ahead of the
+// playhead so that decoding never waits on the disk
+class AsciiVideo
+{
+public:
+
+	AsciiVideo();
+	~AsciiVideo();
+
+	// prefetchFrames: number of frames the prefetch thread keeps ahead of the playhead
+	bool Open(const char* fileName, int prefetchFrames = 16);
+	void Close();
+	bool IsOpen() const;
+
+	// Advances the playback time and decodes the frames reached. Returns true if the frame changed
+	bool Update(float dt, bool loop);
+	void Rewind();
+	bool IsFinished() const;
+	// Playback time until Update reaches the next frame, FLT_MAX if there is none
+	float GetTimeToNextFrame(bool loop) const;
+
+	const CharInfo* GetFrame() const;
+	int GetCols() const;
+	int GetRows() const;
+	int GetFrameIndex() const;
+	int GetNumFrames() const;
+	// Cells written by the last Update
+	int GetChangedCells() const;
+
+private:
+
+	void ClearFrame();
+	int DecodeFrame(int index);
+	void PrefetchLoop();
+
+	MappedFile              file;
+	const AsciiVideoHeader* header;
+	const uint32*           index;
+	std::vector<CharInfo>   frame;
+	int                     frameIndex; // last decoded frame, -1 if none
+	float                   time;
+	int                     changedCells;
+	int                     prefetchFrames;
+	// Prefetch thread, woken up when the playhead moves
+	std::thread             prefetchThread;
+	std::mutex              mutex;
+	std::condition_variable cv;
+	int                     playhead;
+	bool                    quit;
+};
+
+
+// Encoder tool: makes a video of text images (glyphs.txt[,colors.txt]), one per frame, each centered
+// in a canvas as large as the largest image
+int RunVideoEncoder(const char* fileName, float frameRate, int numArgs, char* args[]);
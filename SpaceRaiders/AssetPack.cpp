@@ -0,0 +1,399 @@
+#include "AssetPack.h"
+#include "Images.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+
+namespace
+{
+
+constexpr uint32 assetPackMagic = 0x50415253; // "SRAP"
+constexpr uint32 assetPackVersion = 1;
+
+
+uint32 Align8(size_t offset)
+{
+	return (uint32)((offset + 7) & ~size_t(7));
+}
+
+
+// Number of glyphs of a plane in the image literal layout
+size_t GetPlaneLength(int width, int height)
+{
+	return 1 + (size_t)height * (width + 1) + 1; // first new line, rows with their new line, null
+}
+
+
+// Decodes one UTF-8 sequence, glyphs outside the BMP are replaced by '?'
+wchar_t DecodeUTF8(const char*& p, const char* end)
+{
+	const uint8 c = (uint8)*p++;
+	if (c < 0x80)
+	{
+		return c;
+	}
+	int n = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : 0;
+	uint32 ch = c & (0x3F >> n);
+	for (; n > 0 && p < end && ((uint8)*p & 0xC0) == 0x80; --n)
+	{
+		ch = (ch << 6) | ((uint8)*p++ & 0x3F);
+	}
+	return (n == 0 && ch <= 0xFFFF) ? (wchar_t)ch : L'?';
+}
+
+
+// Splits text in lines without their line ending, drops the trailing empty lines
+template<typename Line>
+void SplitLines(const char* text, size_t size, std::vector<Line>& lines)
+{
+	const char* p = text;
+	const char* end = text + size;
+	if (size >= 3 && !memcmp(p, "\xEF\xBB\xBF", 3))
+	{
+		p += 3; // BOM
+	}
+	while (p < end)
+	{
+		const char* eol = std::find(p, end, '\n');
+		const char* lineEnd = (eol > p && eol[-1] == '\r') ? eol - 1 : eol;
+		lines.emplace_back(p, lineEnd);
+		p = (eol < end) ? eol + 1 : end;
+	}
+	while (!lines.empty() && lines.back().first == lines.back().second)
+	{
+		lines.pop_back();
+	}
+}
+
+typedef std::pair<const char*, const char*> TextLine;
+
+
+// Copies a plane in the image literal layout. Some literals have rows shorter than the image width,
+// those are padded so that packed planes always have the exact layout
+template<typename T>
+void CopyPlane(T* dst, const T* src, int width, int height, T pad)
+{
+	*dst++ = '\n';
+	if (*src == '\n')
+	{
+		++src;
+	}
+	for (int y = 0; y < height; ++y)
+	{
+		int x = 0;
+		for (; *src && *src != '\n'; ++src)
+		{
+			if (x < width)
+			{
+				dst[x++] = *src;
+			}
+		}
+		for (; x < width; ++x)
+		{
+			dst[x] = pad;
+		}
+		dst += width;
+		*dst++ = '\n';
+		if (*src)
+		{
+			++src;
+		}
+	}
+	*dst = 0;
+}
+
+}
+
+
+bool AssetPack::Open(const char* fileName)
+{
+	Close();
+	if (!file.Open(fileName))
+	{
+		return false;
+	}
+	const byte* base = static_cast<const byte*>(file.GetData());
+	const size_t size = file.GetSize();
+	const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(base);
+	if (size < sizeof(AssetPackHeader) || header->magic != assetPackMagic || header->version != assetPackVersion
+		|| header->glyphSize != sizeof(wchar_t) || sizeof(AssetPackHeader) + (size_t)header->numImages * sizeof(AssetPackEntry) > size
+		|| (size_t)header->glyphsOffset + header->numGlyphs * sizeof(uint16) > size)
+	{
+		file.Close();
+		return false;
+	}
+	// Validate the index once, lookups then don't check anything
+	const AssetPackEntry* entries = reinterpret_cast<const AssetPackEntry*>(header + 1);
+	images.resize(header->numImages);
+	for (uint32 i = 0; i < header->numImages; ++i)
+	{
+		const AssetPackEntry& e = entries[i];
+		const size_t length = GetPlaneLength(e.width, e.height);
+		if (e.width <= 0 || e.height <= 0 || e.name[sizeof(e.name) - 1] != 0 || e.imgOffset % sizeof(wchar_t)
+			|| (size_t)e.imgOffset + length * sizeof(wchar_t) > size || (e.colorsOffset && (size_t)e.colorsOffset + length > size))
+		{
+			Close();
+			return false;
+		}
+		Image& image = images[i];
+		image.img = reinterpret_cast<const wchar_t*>(base + e.imgOffset);
+		image.colors = e.colorsOffset ? base + e.colorsOffset : nullptr;
+		image.width = e.width;
+		image.height = e.height;
+	}
+	return true;
+}
+
+
+void AssetPack::Close()
+{
+	images.clear();
+	file.Close();
+}
+
+
+bool AssetPack::IsOpen() const
+{
+	return file.IsOpen();
+}
+
+
+int AssetPack::GetNumImages() const
+{
+	return (int)images.size();
+}
+
+
+const char* AssetPack::GetImageName(int index) const
+{
+	assert(index >= 0 && index < GetNumImages());
+	const AssetPackHeader* header = static_cast<const AssetPackHeader*>(file.GetData());
+	return reinterpret_cast<const AssetPackEntry*>(header + 1)[index].name;
+}
+
+
+const Image& AssetPack::GetImage(int index) const
+{
+	assert(index >= 0 && index < GetNumImages());
+	return images[index];
+}
+
+
+const Image* AssetPack::FindImage(const char* name) const
+{
+	for (int i = 0; i < GetNumImages(); ++i)
+	{
+		if (!strcmp(GetImageName(i), name))
+		{
+			return &images[i];
+		}
+	}
+	return nullptr;
+}
+
+
+const uint16* AssetPack::GetGlyphs(int& count) const
+{
+	const byte* base = static_cast<const byte*>(file.GetData());
+	const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(base);
+	count = header ? (int)header->numGlyphs : 0;
+	return header ? reinterpret_cast<const uint16*>(base + header->glyphsOffset) : nullptr;
+}
+
+
+bool ParseTextImage(TextImage& image, const char* text, size_t size, const char* colorText, size_t colorSize)
+{
+	std::vector<TextLine> lines;
+	SplitLines(text, size, lines);
+	if (lines.empty())
+	{
+		return false;
+	}
+	std::vector<std::vector<wchar_t>> rows(lines.size());
+	size_t width = 0;
+	for (size_t i = 0; i < lines.size(); ++i)
+	{
+		for (const char* p = lines[i].first; p < lines[i].second; )
+		{
+			rows[i].push_back(DecodeUTF8(p, lines[i].second));
+		}
+		width = std::max(width, rows[i].size());
+	}
+	if (width == 0)
+	{
+		return false;
+	}
+	image.width = (int)width;
+	image.height = (int)rows.size();
+	image.img.clear();
+	image.img.reserve(GetPlaneLength(image.width, image.height));
+	image.img.push_back(L'\n');
+	for (auto& row : rows)
+	{
+		row.resize(width, L' ');
+		image.img.insert(image.img.end(), row.begin(), row.end());
+		image.img.push_back(L'\n');
+	}
+	image.img.push_back(0);
+
+	image.colors.clear();
+	if (colorText)
+	{
+		std::vector<TextLine> colorLines;
+		SplitLines(colorText, colorSize, colorLines);
+		image.colors.push_back('\n');
+		for (int y = 0; y < image.height; ++y)
+		{
+			const TextLine line = y < (int)colorLines.size() ? colorLines[y] : TextLine { nullptr, nullptr };
+			for (int x = 0; x < image.width; ++x)
+			{
+				// Missing colors are white
+				const bool valid = x < line.second - line.first && line.first[x] >= '0' && line.first[x] <= '=';
+				image.colors.push_back(valid ? (byte)line.first[x] : (byte)'8');
+			}
+			image.colors.push_back('\n');
+		}
+		image.colors.push_back(0);
+	}
+	return true;
+}
+
+
+bool LoadTextImage(TextImage& image, const char* fileName, const char* colorFileName)
+{
+	MappedFile text, colors;
+	if (!text.Open(fileName) || (colorFileName && !colors.Open(colorFileName)))
+	{
+		return false;
+	}
+	return ParseTextImage(image, static_cast<const char*>(text.GetData()), text.GetSize(),
+		static_cast<const char*>(colors.GetData()), colors.GetSize());
+}
+
+
+bool WriteAssetPack(const char* fileName, const AssetPackSource* sources, int count)
+{
+	assert(count >= 0);
+	// All the glyphs used, so that the glyph table can be built without scanning the images
+	std::vector<uint16> glyphs;
+	for (int i = 0; i < count; ++i)
+	{
+		for (const wchar_t* s = sources[i].image.img; *s; ++s)
+		{
+			if (*s != L'\n')
+			{
+				glyphs.push_back((uint16)*s);
+			}
+		}
+	}
+	std::sort(glyphs.begin(), glyphs.end());
+	glyphs.erase(std::unique(glyphs.begin(), glyphs.end()), glyphs.end());
+
+	AssetPackHeader header;
+	header.magic = assetPackMagic;
+	header.version = assetPackVersion;
+	header.glyphSize = sizeof(wchar_t);
+	header.numImages = (uint32)count;
+	header.numGlyphs = (uint32)glyphs.size();
+	header.glyphsOffset = (uint32)(sizeof(AssetPackHeader) + count * sizeof(AssetPackEntry));
+	// Lay out the planes
+	std::vector<AssetPackEntry> entries(count);
+	size_t offset = Align8(header.glyphsOffset + glyphs.size() * sizeof(uint16));
+	for (int i = 0; i < count; ++i)
+	{
+		const AssetPackSource& src = sources[i];
+		AssetPackEntry& e = entries[i];
+		memset(&e, 0, sizeof(e));
+		snprintf(e.name, sizeof(e.name), "%s", src.name);
+		e.width = src.image.width;
+		e.height = src.image.height;
+		const size_t length = GetPlaneLength(e.width, e.height);
+		e.imgOffset = (uint32)offset;
+		offset = Align8(offset + length * sizeof(wchar_t));
+		if (src.image.colors)
+		{
+			e.colorsOffset = (uint32)offset;
+			offset = Align8(offset + length);
+		}
+	}
+
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+	{
+		return false;
+	}
+	std::vector<byte> data(offset, 0);
+	memcpy(data.data(), &header, sizeof(header));
+	memcpy(data.data() + sizeof(header), entries.data(), entries.size() * sizeof(AssetPackEntry));
+	memcpy(data.data() + header.glyphsOffset, glyphs.data(), glyphs.size() * sizeof(uint16));
+	for (int i = 0; i < count; ++i)
+	{
+		const AssetPackEntry& e = entries[i];
+		CopyPlane(reinterpret_cast<wchar_t*>(data.data() + e.imgOffset), sources[i].image.img, e.width, e.height, L' ');
+		if (e.colorsOffset)
+		{
+			CopyPlane(data.data() + e.colorsOffset, sources[i].image.colors, e.width, e.height, (byte)'8');
+		}
+	}
+	const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	return (fclose(file) == 0) && ok;
+}
+
+
+int RunAssetPacker(const char* fileName, int numArgs, char* args[])
+{
+	std::vector<AssetPackSource> sources;
+	for (size_t i = 1; i < numImages; ++i)
+	{
+		const Image& image = ::GetImage((ImageId)i);
+		if (image.img)
+		{
+			sources.push_back( { GetImageName((ImageId)i), image } );
+		}
+	}
+	std::vector<std::unique_ptr<TextImage>> textImages;
+	for (int i = 0; i < numArgs; ++i)
+	{
+		// name=glyphs.txt[,colors.txt]
+		char* name = args[i];
+		char* glyphFile = strchr(name, '=');
+		if (!glyphFile)
+		{
+			fprintf(stderr, "Expected name=glyphs.txt[,colors.txt]: %s\n", name);
+			return 1;
+		}
+		*glyphFile++ = 0;
+		char* colorFile = strchr(glyphFile, ',');
+		if (colorFile)
+		{
+			*colorFile++ = 0;
+		}
+		textImages.emplace_back(new TextImage);
+		TextImage& textImage = *textImages.back();
+		if (!LoadTextImage(textImage, glyphFile, colorFile))
+		{
+			fprintf(stderr, "Can't load %s\n", glyphFile);
+			return 1;
+		}
+		const Image image = { textImage.img.data(), textImage.colors.empty() ? nullptr : textImage.colors.data(), textImage.width, textImage.height };
+		auto it = std::find_if(sources.begin(), sources.end(), [name](const AssetPackSource& s) { return !strcmp(s.name, name); });
+		if (it != sources.end())
+		{
+			it->image = image;
+		}
+		else
+		{
+			sources.push_back( { name, image } );
+		}
+	}
+	if (!WriteAssetPack(fileName, sources.data(), (int)sources.size()))
+	{
+		fprintf(stderr, "Can't write %s\n", fileName);
+		return 1;
+	}
+	printf("%s: %d images\n", fileName, (int)sources.size());
+	return 0;
+}
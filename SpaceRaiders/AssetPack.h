@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Base.h"
+#include "Image.h"
+#include "MappedFile.h"
+#include <vector>
+
+
+// Binary image pack. The file starts with a header and an index of the images, followed by the list
+// of all the glyphs used and by the glyph and color planes. Planes are stored exactly as the image
+// literals of Images.cpp (a new line before each row and at the end, null terminated), so images
+// point straight into the mapped file
+struct AssetPackHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint32 glyphSize;    // sizeof(wchar_t) of the packer, packs are not portable between platforms
+	uint32 numImages;
+	uint32 numGlyphs;
+	uint32 glyphsOffset; // uint16 list of the glyphs used by the images
+};
+
+struct AssetPackEntry
+{
+	char   name[32];
+	int32  width;
+	int32  height;
+	uint32 imgOffset;
+	uint32 colorsOffset; // 0 if the image has no colors
+};
+
+
+class AssetPack
+{
+public:
+
+	bool Open(const char* fileName);
+	void Close();
+	bool IsOpen() const;
+
+	int GetNumImages() const;
+	const char* GetImageName(int index) const;
+	const Image& GetImage(int index) const;
+	// Null if the pack has no image with that name
+	const Image* FindImage(const char* name) const;
+	const uint16* GetGlyphs(int& count) const;
+
+private:
+
+	MappedFile         file;
+	std::vector<Image> images; // point into the mapped file
+};
+
+
+// Image built from a text file: UTF-8 glyph rows and optional color rows, one digit per glyph
+struct TextImage
+{
+	std::vector<wchar_t> img;    // same layout as the image literals
+	std::vector<byte>    colors; // empty if no colors
+	int                  width;
+	int                  height;
+};
+
+// Rows may end with LF or CRLF, short rows are padded with spaces
+bool ParseTextImage(TextImage& image, const char* text, size_t size, const char* colorText, size_t colorSize);
+bool LoadTextImage(TextImage& image, const char* fileName, const char* colorFileName);
+
+struct AssetPackSource
+{
+	const char* name;
+	Image       image;
+};
+
+bool WriteAssetPack(const char* fileName, const AssetPackSource* sources, int count);
+
+// Packer tool: packs all the built-in images, replaced or extended by text files given as
+// name=glyphs.txt[,colors.txt]
+int RunAssetPacker(const char* fileName, int numArgs, char* args[]);
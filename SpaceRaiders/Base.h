@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define UNUSED( x ) ( &reinterpret_cast< const size_t& >( x ) )
 
@@ -27,7 +28,18 @@ typedef uint16_t word;
 typedef uint32_t dword;
 
 
+#if defined(_WIN32)
 #define DLL_EXPORT extern "C" __declspec( dllexport )
+#else
+#define DLL_EXPORT extern "C" __attribute__(( visibility( "default" ) ))
+#endif
+
+// Number of elements of an array, _countof is MSVC only
+#ifndef _countof
+template <typename T, size_t N>
+char (&CountOfHelper(T (&)[N]))[N];
+#define _countof(a) sizeof(CountOfHelper(a))
+#endif
 
 
 #define XMAS_EDITION 1
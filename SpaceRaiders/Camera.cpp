@@ -0,0 +1,49 @@
+#include "Camera.h"
+#include "PlayField.h"
+#include "Player.h"
+#include <algorithm>
+
+
+namespace
+{
+
+constexpr float followRate = 4.f; // fraction of the distance to the target covered per second
+
+
+Vector2D Clamp(const Camera& camera, const Vector2D& pos)
+{
+	return {
+		std::max(0.f, std::min(camera.worldSize.x - camera.viewSize.x, pos.x)),
+		std::max(0.f, std::min(camera.worldSize.y - camera.viewSize.y, pos.y))
+	};
+}
+
+}
+
+
+Camera NewCamera(const Vector2D& viewSize, const Vector2D& worldSize)
+{
+	Camera camera { { 0.f, 0.f }, viewSize, worldSize };
+	// Start centered horizontally, at the bottom where the players are
+	camera.pos = Clamp(camera, { (worldSize.x - viewSize.x) * 0.5f, worldSize.y - viewSize.y });
+	return camera;
+}
+
+
+void FollowPlayers(Camera& camera, const PlayField& world, float dt)
+{
+	const auto& players = world.GetPlayers();
+	if (players.empty())
+	{
+		return;
+	}
+	Vector2D center { 0.f, 0.f };
+	for (const auto& player : players)
+	{
+		center = Add(center, player.pos);
+	}
+	center = Mul(center, 1.f / (float)players.size());
+	const Vector2D target = Clamp(camera, { center.x - camera.viewSize.x * 0.5f, center.y - camera.viewSize.y * 0.5f });
+	const float t = std::min(1.f, followRate * dt);
+	camera.pos = Lerp(camera.pos, target, t);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Vector2D.h"
+
+class PlayField;
+
+
+// View on the play field when the world is larger than the console
+struct Camera
+{
+	Vector2D pos;       // top left corner of the view in world coordinates
+	Vector2D viewSize;
+	Vector2D worldSize;
+};
+
+
+Camera NewCamera(const Vector2D& viewSize, const Vector2D& worldSize);
+// Moves the camera towards the center of the players, the view stays inside the world
+void FollowPlayers(Camera& camera, const PlayField& world, float dt);
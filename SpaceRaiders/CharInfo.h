@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Base.h"
+#include "Colors.h"
+
+
+// Console character cell. Binary compatible with the Win32 CHAR_INFO struct so that a canvas
+// can be written to a Win32 console without any conversion
+struct CharInfo
+{
+	uint16 ch;         // UTF-16 code unit, all glyphs are in the BMP
+	uint16 attributes; // see CharAttribute
+};
+static_assert(sizeof(CharInfo) == 4, "CharInfo must match the layout of CHAR_INFO");
+
+
+// Same bit layout as the Win32 console attributes (FOREGROUND_RED etc.)
+namespace CharAttribute
+{
+
+constexpr uint16 foregroundBlue      = 0x0001;
+constexpr uint16 foregroundGreen     = 0x0002;
+constexpr uint16 foregroundRed       = 0x0004;
+constexpr uint16 foregroundIntensity = 0x0008;
+constexpr uint16 backgroundBlue      = 0x0010;
+constexpr uint16 backgroundGreen     = 0x0020;
+constexpr uint16 backgroundRed       = 0x0040;
+constexpr uint16 backgroundIntensity = 0x0080;
+constexpr uint16 foregroundMask      = 0x000F;
+constexpr uint16 backgroundMask      = 0x00F0;
+
+}
+
+
+// Foreground attributes of a color
+uint16 GetColorAttributes(Color color);
@@ -1,4 +1,5 @@
 #include "CollisionSpace.h"
+#include "Profiler.h"
 #include <algorithm>
 
 
@@ -36,6 +37,7 @@ inline uint64 MakeBit(ColliderId id0, ColliderId id1)
 
 int CollisionSpace::Execute(CollisionInfo collisionInfo[], int maxCollisions) const
 {
+	PROFILE_ZONE("CollisionSpace::Execute");
 	const int nc = (int)colliderData.size();
 	int nci = 0;
 	const ColliderData* c0 = colliderData.data();
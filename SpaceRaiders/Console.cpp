@@ -1,7 +1,10 @@
 #include "Console.h"
+#include "CharInfo.h"
+#include "Profiler.h"
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#undef WriteConsoleOutput
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
@@ -17,3 +20,24 @@ bool InitConsole(Console& console)
 	}
 	return true;
 }
+
+
+ConsolePresenter::ConsolePresenter(Console& console_) :
+	console { console_ }
+{}
+
+
+bool ConsolePresenter::Initialize(int cols, int rows, int fontSize)
+{
+	bool r = ResizeConsole(console.handle, cols, rows, fontSize);
+	r = r && CenterConsoleOnDesktop();
+	return r;
+}
+
+
+void ConsolePresenter::Present(const CharInfo* canvas, int cols, int rows)
+{
+	PROFILE_ZONE("ConsolePresenter::Present");
+	// CharInfo has the same layout as CHAR_INFO
+	WriteConsoleOutput(console.handle, canvas, cols, rows, 0, 0);
+}
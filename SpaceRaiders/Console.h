@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Presenter.h"
+
 
 struct Console
 {
@@ -13,3 +15,22 @@ bool CenterConsoleOnDesktop();
 void HideConsoleCursor(void* consoleHandle);
 void ShowConsoleCursor(void* consoleHandle);
 bool ResizeConsole(void* consoleHandle, int cols, int rows, int fontSize);
+// Let the console interpret VT escape sequences (Windows 10 and later)
+bool EnableVirtualTerminal(void* consoleHandle);
+
+
+// Writes canvases to a Win32 console
+class ConsolePresenter final : public Presenter
+{
+public:
+
+	explicit ConsolePresenter(Console& console);
+
+	// Resize the console to fit the canvas and center it on the desktop
+	bool Initialize(int cols, int rows, int fontSize);
+	void Present(const CharInfo* canvas, int cols, int rows) override;
+
+private:
+
+	Console& console;
+};
@@ -0,0 +1,75 @@
+#include "CpuUsage.h"
+#include <cassert>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+double GetProcessCpuTime()
+{
+#if defined(_WIN32)
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+	{
+		return 0.;
+	}
+	// 100 ns units
+	const uint64 kernel = ((uint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+	const uint64 user = ((uint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+	return (double)(kernel + user) * 1e-7;
+#else
+	timespec ts;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+	{
+		return 0.;
+	}
+	return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+
+void CpuUsage::Start(int numCategories)
+{
+	assert(numCategories > 0);
+	categories.assign(numCategories, { 0., 0., 0 });
+}
+
+
+void CpuUsage::Add(int category, double cpuTime, double wallTime)
+{
+	assert(category >= 0 && category < (int)categories.size());
+	Category& c = categories[category];
+	c.cpuTime += cpuTime;
+	c.wallTime += wallTime;
+	++c.frames;
+}
+
+
+double CpuUsage::GetCpuTime(int category) const
+{
+	return categories[category].cpuTime;
+}
+
+
+double CpuUsage::GetWallTime(int category) const
+{
+	return categories[category].wallTime;
+}
+
+
+uint64 CpuUsage::GetFrames(int category) const
+{
+	return categories[category].frames;
+}
+
+
+double CpuUsage::GetLoad(int category) const
+{
+	const Category& c = categories[category];
+	return c.wallTime > 0. ? c.cpuTime / c.wallTime : 0.;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Base.h"
+#include <vector>
+
+
+// CPU time used by the process since it started, all threads [s]
+double GetProcessCpuTime();
+
+
+// CPU time, wall time and frames per category (e.g. game state), to tell which ones keep the CPU busy
+class CpuUsage
+{
+public:
+
+	void Start(int numCategories);
+	// CPU and wall time of one frame [s]
+	void Add(int category, double cpuTime, double wallTime);
+
+	double GetCpuTime(int category) const;
+	double GetWallTime(int category) const;
+	uint64 GetFrames(int category) const;
+	// CPU time over wall time, 1 for one busy core
+	double GetLoad(int category) const;
+
+private:
+
+	struct Category
+	{
+		double cpuTime;
+		double wallTime;
+		uint64 frames;
+	};
+
+	std::vector<Category> categories;
+};
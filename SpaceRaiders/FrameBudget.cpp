@@ -0,0 +1,268 @@
+#include "FrameBudget.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+
+namespace
+{
+
+// Part of the budget given to the measured stages, the rest absorbs wake up jitter and the work that
+// is not measured
+constexpr double headroom = 0.9;
+// Weight of a new measure in the moving averages
+constexpr double smoothing = 0.1;
+// Cosmetic work runs at least once every maxDeferredFrames frames
+constexpr int maxDeferredFrames = 8;
+// Cost of a detail level not measured yet, relative to the level above
+constexpr double detailCostRatio = 0.8;
+
+const char* const detailNames[(int)RenderDetail::count] =
+{
+	"full",
+	"noParticles",
+	"flat"
+};
+
+
+void Smooth(double& average, double value)
+{
+	average = average < 0. ? value : average + (value - average) * smoothing;
+}
+
+}
+
+
+FrameBudget::FrameBudget()
+{
+	Start(1. / 60., 2);
+}
+
+
+void FrameBudget::Start(double budget_, int maxSkippedFrames_)
+{
+	assert(budget_ > 0.);
+	assert(maxSkippedFrames_ >= 0);
+	budget = budget_;
+	maxSkippedFrames = maxSkippedFrames_;
+	skippedInRow = 0;
+	deferredInRow = 0;
+	stepCost = -1.;
+	std::fill(renderCost, renderCost + (int)RenderDetail::count, -1.);
+	presentCost = -1.;
+	frameCount = 0;
+	degradedFrames = 0;
+	skippedFrames = 0;
+	deferredFrames = 0;
+	std::fill(detailFrames, detailFrames + (int)RenderDetail::count, 0);
+	records.clear();
+	records.reserve(maxRecords);
+	nextRecord = 0;
+}
+
+
+void FrameBudget::AddMeasure(FrameStage stage, double seconds, int count, RenderDetail detail)
+{
+	switch (stage)
+	{
+	case FrameStage::step:
+		if (count > 0)
+		{
+			Smooth(stepCost, seconds / count);
+		}
+		break;
+	case FrameStage::render:
+		Smooth(renderCost[(int)detail], seconds);
+		break;
+	case FrameStage::present:
+		Smooth(presentCost, seconds);
+		break;
+	default:
+		assert(false);
+	}
+}
+
+
+FrameDecision FrameBudget::Plan(int steps, int backlog)
+{
+	++frameCount;
+	FrameDecision decision { false, RenderDetail::full, false, 0 };
+	const double step = std::max(0., stepCost);
+	const double present = std::max(0., presentCost);
+	double left = budget * headroom - steps * step;
+
+	// Highest detail that fits after the due steps
+	for (int d = 0; d < (int)RenderDetail::count; ++d)
+	{
+		if (GetRenderCost((RenderDetail)d) + present <= left)
+		{
+			decision.present = true;
+			decision.detail = (RenderDetail)d;
+			break;
+		}
+	}
+	// Falling behind: the render time goes to the late steps
+	if (backlog > std::max(1, steps) && skippedInRow < maxSkippedFrames)
+	{
+		decision.present = false;
+	}
+	// The screen must still move
+	if (! decision.present && skippedInRow >= maxSkippedFrames)
+	{
+		decision.present = true;
+		decision.detail = (RenderDetail)((int)RenderDetail::count - 1);
+	}
+	if (decision.present)
+	{
+		left -= GetRenderCost(decision.detail) + present;
+		skippedInRow = 0;
+	}
+	else
+	{
+		++skippedInRow;
+	}
+
+	if (left < 0. && deferredInRow < maxDeferredFrames)
+	{
+		decision.deferChores = true;
+		++deferredInRow;
+	}
+	else
+	{
+		deferredInRow = 0;
+	}
+
+	// Late steps in the time left. Until the step cost is known, at most as many as due
+	if (backlog > 0)
+	{
+		const int fit = step > 0. ? (int)std::min(left / step, (double)backlog) : std::max(1, steps);
+		decision.extraSteps = std::max(0, std::min(fit, backlog));
+	}
+
+	const bool degraded = ! decision.present || decision.detail != RenderDetail::full || decision.deferChores;
+	if (degraded)
+	{
+		++degradedFrames;
+	}
+	if (! decision.present)
+	{
+		++skippedFrames;
+	}
+	else
+	{
+		++detailFrames[(int)decision.detail];
+	}
+	if (decision.deferChores)
+	{
+		++deferredFrames;
+	}
+	if (degraded || backlog > 0)
+	{
+		const Record record { frameCount, steps, backlog, decision.extraSteps, (float)(step * 1e3),
+			(float)(GetRenderCost(decision.detail) * 1e3), (float)(present * 1e3), decision };
+		if ((int)records.size() < maxRecords)
+		{
+			records.push_back(record);
+		}
+		else
+		{
+			records[nextRecord] = record;
+		}
+		nextRecord = (nextRecord + 1) % maxRecords;
+	}
+	return decision;
+}
+
+
+double FrameBudget::GetCost(FrameStage stage, RenderDetail detail) const
+{
+	switch (stage)
+	{
+	case FrameStage::step:
+		return std::max(0., stepCost);
+	case FrameStage::render:
+		return GetRenderCost(detail);
+	case FrameStage::present:
+		return std::max(0., presentCost);
+	default:
+		assert(false);
+		return 0.;
+	}
+}
+
+
+uint64 FrameBudget::GetFrameCount() const
+{
+	return frameCount;
+}
+
+
+uint64 FrameBudget::GetDegradedFrames() const
+{
+	return degradedFrames;
+}
+
+
+uint64 FrameBudget::GetSkippedFrames() const
+{
+	return skippedFrames;
+}
+
+
+uint64 FrameBudget::GetDeferredFrames() const
+{
+	return deferredFrames;
+}
+
+
+uint64 FrameBudget::GetDetailFrames(RenderDetail detail) const
+{
+	return detailFrames[(int)detail];
+}
+
+
+std::vector<FrameBudget::Record> FrameBudget::GetRecords() const
+{
+	std::vector<Record> ordered;
+	ordered.reserve(records.size());
+	const int first = (int)records.size() < maxRecords ? 0 : nextRecord;
+	for (int i = 0; i < (int)records.size(); ++i)
+	{
+		ordered.push_back(records[(first + i) % records.size()]);
+	}
+	return ordered;
+}
+
+
+bool FrameBudget::WriteRecords(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "frame,steps,backlog,extra_steps,step_ms,render_ms,present_ms,presented,detail,deferred_chores\n");
+	for (const Record& r : GetRecords())
+	{
+		fprintf(file, "%llu,%d,%d,%d,%.3f,%.3f,%.3f,%d,%s,%d\n", (unsigned long long)r.frame, r.steps, r.backlog, r.extraSteps,
+			r.stepCost, r.renderCost, r.presentCost, r.decision.present ? 1 : 0, detailNames[(int)r.decision.detail], r.decision.deferChores ? 1 : 0);
+	}
+	return fclose(file) == 0;
+}
+
+
+double FrameBudget::GetRenderCost(RenderDetail detail) const
+{
+	// Levels not measured yet are estimated from the nearest measured level above, optimistic until
+	// the full detail is measured so the first frames are drawn in full
+	double ratio = 1.;
+	for (int d = (int)detail; d >= 0; --d)
+	{
+		if (renderCost[d] >= 0.)
+		{
+			return renderCost[d] * ratio;
+		}
+		ratio *= detailCostRatio;
+	}
+	return 0.;
+}
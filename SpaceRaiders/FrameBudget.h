@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Base.h"
+#include "Renderer.h"
+#include <vector>
+
+
+// Stages of a frame whose cost is measured
+enum class FrameStage
+{
+	step,    // one simulation step
+	render,  // drawing the canvas, at the detail it was drawn with
+	present, // sending the canvas to the presenters
+	count
+};
+
+// What a frame does to fit its budget
+struct FrameDecision
+{
+	bool         present;     // render and present the frame
+	RenderDetail detail;
+	bool         deferChores; // postpone cosmetic work (message aging, snow flakes) to a later frame
+	int          extraSteps;  // steps of the backlog to run on top of the due ones
+};
+
+
+// Frame budget scheduler. Knows the cost of every stage from measurements and decides, frame by frame,
+// how to fit the due simulation steps in the frame time: lower the render detail, skip the
+// presentation (never more than maxSkippedFrames in a row) and postpone cosmetic work. Simulation steps
+// are never dropped, the ones that do not fit run in later frames. Every degraded or late frame is
+// recorded
+class FrameBudget
+{
+public:
+
+	struct Record
+	{
+		uint64        frame;
+		int           steps;       // due steps
+		int           backlog;     // steps still late before the frame
+		int           extraSteps;
+		float         stepCost;    // [ms] expected costs
+		float         renderCost;
+		float         presentCost;
+		FrameDecision decision;
+	};
+
+	FrameBudget();
+
+	// budget: frame time [s]
+	void Start(double budget, int maxSkippedFrames);
+	// Measured time of a stage. count: number of steps for FrameStage::step
+	void AddMeasure(FrameStage stage, double seconds, int count = 1, RenderDetail detail = RenderDetail::full);
+	// steps: steps due this frame, backlog: steps due but left for later frames
+	FrameDecision Plan(int steps, int backlog);
+
+	double GetCost(FrameStage stage, RenderDetail detail = RenderDetail::full) const; // [s]
+	uint64 GetFrameCount() const;
+	uint64 GetDegradedFrames() const;
+	uint64 GetSkippedFrames() const;
+	uint64 GetDeferredFrames() const;
+	uint64 GetDetailFrames(RenderDetail detail) const; // presented frames per detail
+	// Last degraded or late frames, oldest first
+	static constexpr int maxRecords = 1024;
+	std::vector<Record> GetRecords() const;
+	// CSV, one line per record
+	bool WriteRecords(const char* fileName) const;
+
+private:
+
+	double GetRenderCost(RenderDetail detail) const;
+
+	double budget;
+	int    maxSkippedFrames;
+	int    skippedInRow;
+	int    deferredInRow;
+	// Exponential moving averages of the measured costs, < 0 until measured
+	double stepCost;
+	double renderCost[(int)RenderDetail::count];
+	double presentCost;
+	uint64 frameCount;
+	uint64 degradedFrames;
+	uint64 skippedFrames;
+	uint64 deferredFrames;
+	uint64 detailFrames[(int)RenderDetail::count];
+	std::vector<Record> records; // ring buffer
+	int    nextRecord;
+};
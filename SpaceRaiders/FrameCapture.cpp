@@ -0,0 +1,254 @@
+#include "FrameCapture.h"
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+
+namespace
+{
+
+// Flush to the I/O thread when this amount of bytes is pending
+constexpr size_t flushSize = 64 * 1024;
+
+
+// FNV-1a
+uint64 Hash(const void* data, size_t size)
+{
+	const byte* p = static_cast<const byte*>(data);
+	uint64 h = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		h = (h ^ p[i]) * 1099511628211ull;
+	}
+	return h;
+}
+
+}
+
+
+CaptureFormat GetCaptureFormat(const char* name)
+{
+	if (!strcmp(name, "text"))
+	{
+		return CaptureFormat::text;
+	}
+	if (!strcmp(name, "asciicast"))
+	{
+		return CaptureFormat::asciicast;
+	}
+	if (!strcmp(name, "digest"))
+	{
+		return CaptureFormat::digest;
+	}
+	return CaptureFormat::none;
+}
+
+
+FrameCapture::FrameCapture() :
+	frameCount { 0 },
+	frameDigest { 0 },
+	format { CaptureFormat::none },
+	frameRate { 60.f },
+	file { nullptr },
+	quit { false }
+{}
+
+
+FrameCapture::~FrameCapture()
+{
+	Close();
+}
+
+
+bool FrameCapture::Open(const char* fileName, CaptureFormat format_, int cols, int rows, float frameRate_)
+{
+	assert(fileName);
+	assert(frameRate_ > 0.f);
+	Close();
+	if (format_ == CaptureFormat::none)
+	{
+		return false;
+	}
+	file = fopen(fileName, "wb");
+	if (! file)
+	{
+		return false;
+	}
+	format = format_;
+	frameRate = frameRate_;
+	frameCount = 0;
+	vtEncoder.Reset();
+	if (format == CaptureFormat::asciicast)
+	{
+		char header[128];
+		snprintf(header, sizeof(header), "{\"version\": 2, \"width\": %d, \"height\": %d}\n", cols, rows);
+		pending = header;
+	}
+	quit = false;
+	ioThread = std::thread(&FrameCapture::WriteLoop, this);
+	return true;
+}
+
+
+void FrameCapture::Close()
+{
+	if (ioThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+		}
+		cv.notify_one();
+		ioThread.join();
+	}
+	if (file)
+	{
+		fclose(file);
+		file = nullptr;
+	}
+	format = CaptureFormat::none;
+	pending.clear();
+}
+
+
+bool FrameCapture::IsOpen() const
+{
+	return file != nullptr;
+}
+
+
+void FrameCapture::Present(const CharInfo* canvas, int cols, int rows)
+{
+	const size_t numCells = (size_t)cols * rows;
+	frame.assign(canvas, canvas + numCells);
+	frameDigest = Hash(frame.data(), numCells * sizeof(CharInfo));
+
+	if (format != CaptureFormat::none)
+	{
+		encoded.clear();
+		switch (format)
+		{
+		case CaptureFormat::text:
+			EncodeText(canvas, cols, rows);
+			break;
+		case CaptureFormat::asciicast:
+			EncodeAsciicast(canvas, cols, rows);
+			break;
+		case CaptureFormat::digest:
+			EncodeDigest();
+			break;
+		default:
+			break;
+		}
+		bool notify;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending += encoded;
+			notify = pending.size() >= flushSize;
+		}
+		if (notify)
+		{
+			cv.notify_one();
+		}
+	}
+	++frameCount;
+}
+
+
+const std::vector<CharInfo>& FrameCapture::GetFrame() const
+{
+	return frame;
+}
+
+
+uint64 FrameCapture::GetFrameCount() const
+{
+	return frameCount;
+}
+
+
+uint64 FrameCapture::GetFrameDigest() const
+{
+	return frameDigest;
+}
+
+
+void FrameCapture::EncodeText(const CharInfo* canvas, int cols, int rows)
+{
+	for (int y = 0; y < rows; ++y)
+	{
+		const CharInfo* row = canvas + y * cols;
+		for (int x = 0; x < cols; ++x)
+		{
+			const GlyphUTF8& glyph = GetGlyphUTF8(row[x].ch);
+			encoded.append(glyph.bytes, glyph.length);
+		}
+		encoded += '\n';
+	}
+	encoded += '\n'; // empty line between frames
+}
+
+
+void FrameCapture::EncodeAsciicast(const CharInfo* canvas, int cols, int rows)
+{
+	// Event: [time, "o", data]. Data is the JSON escaped terminal output, only the changes since
+	// the previous frame are recorded
+	vtFrame.clear();
+	vtEncoder.Encode(canvas, cols, rows, vtFrame);
+	if (vtFrame.empty())
+	{
+		return;
+	}
+	char tmp[64];
+	snprintf(tmp, sizeof(tmp), "[%.6f, \"o\", \"", (double)frameCount / frameRate);
+	encoded += tmp;
+	for (char c : vtFrame)
+	{
+		if (c == '"' || c == '\\')
+		{
+			encoded += '\\';
+			encoded += c;
+		}
+		else if ((unsigned char)c < 0x20)
+		{
+			snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+			encoded += tmp;
+		}
+		else
+		{
+			encoded += c;
+		}
+	}
+	encoded += "\"]\n";
+}
+
+
+void FrameCapture::EncodeDigest()
+{
+	char tmp[64];
+	snprintf(tmp, sizeof(tmp), "%llu %016llx\n", (unsigned long long)frameCount, (unsigned long long)frameDigest);
+	encoded += tmp;
+}
+
+
+void FrameCapture::WriteLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		cv.wait(lock, [this] { return quit || pending.size() >= flushSize; });
+		writing.swap(pending);
+		const bool done = quit;
+		lock.unlock();
+		if (! writing.empty())
+		{
+			fwrite(writing.data(), 1, writing.size(), file);
+			writing.clear();
+		}
+		if (done)
+		{
+			break;
+		}
+		lock.lock();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Base.h"
+#include "Presenter.h"
+#include "CharInfo.h"
+#include "TerminalPresenter.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+
+enum class CaptureFormat
+{
+	none,
+	text,       // plain UTF-8 text, one block of rows per frame
+	asciicast,  // asciicast v2 stream, can be replayed with asciinema
+	digest      // one 64 bit hash per frame, for visual regression tests
+};
+
+CaptureFormat GetCaptureFormat(const char* name);
+
+
+// Headless presenter. Keeps the last presented frame in memory and optionally records all the frames
+// to a file. Encoding happens on the calling thread, file writes are done by an I/O thread so that
+// the game loop never waits on the disk
+class FrameCapture final : public Presenter
+{
+public:
+
+	FrameCapture();
+	~FrameCapture();
+
+	// frameRate is used to timestamp the asciicast frames
+	bool Open(const char* fileName, CaptureFormat format, int cols, int rows, float frameRate);
+	// Flushes pending frames and closes the file
+	void Close();
+	bool IsOpen() const;
+
+	void Present(const CharInfo* canvas, int cols, int rows) override;
+
+	const std::vector<CharInfo>& GetFrame() const;
+	uint64 GetFrameCount() const;
+	uint64 GetFrameDigest() const;
+
+private:
+
+	void EncodeText(const CharInfo* canvas, int cols, int rows);
+	void EncodeAsciicast(const CharInfo* canvas, int cols, int rows);
+	void EncodeDigest();
+	void WriteLoop();
+
+	std::vector<CharInfo> frame;
+	uint64                frameCount;
+	uint64                frameDigest;
+	CaptureFormat         format;
+	float                 frameRate;
+	FILE*                 file;
+	std::string           encoded; // current frame, reused to avoid allocations
+	VTEncoder             vtEncoder;
+	std::string           vtFrame;
+	// Double buffered: the game thread appends to pending, the I/O thread swaps it with writing
+	std::string             pending;
+	std::string             writing;
+	std::mutex              mutex;
+	std::condition_variable cv;
+	std::thread             ioThread;
+	bool                    quit;
+};
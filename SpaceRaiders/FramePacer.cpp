@@ -0,0 +1,217 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <time.h>
+#include <errno.h>
+#endif
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CPU_RELAX() _mm_pause()
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+
+FrameWait GetFrameWait(const char* name)
+{
+	if (!strcmp(name, "sleep"))
+	{
+		return FrameWait::sleep;
+	}
+	if (!strcmp(name, "spin"))
+	{
+		return FrameWait::spin;
+	}
+	return FrameWait::hybrid;
+}
+
+
+FramePacer::FramePacer() :
+	frameTime { 0 },
+	spinTime { 0 },
+	wait { FrameWait::hybrid },
+	maxLagFrames { 4 },
+	lastJitter { 0. },
+	sumJitter { 0. },
+	maxJitter { 0. },
+	frameCount { 0 },
+	resyncCount { 0 },
+	timer { nullptr }
+{
+	memset(jitterHistory, 0, sizeof(jitterHistory));
+#if defined(_WIN32)
+	// High resolution timers wake up within ~0.5 ms instead of the 15.6 ms system tick (Windows 10 1803+)
+	timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!timer)
+	{
+		timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	}
+#endif
+}
+
+
+FramePacer::~FramePacer()
+{
+#if defined(_WIN32)
+	if (timer)
+	{
+		CloseHandle(timer);
+	}
+#endif
+}
+
+
+void FramePacer::Start(double frameTime_, FrameWait wait_, double spinTime_, int maxLagFrames_)
+{
+	assert(frameTime_ > 0.);
+	assert(spinTime_ >= 0.);
+	assert(maxLagFrames_ > 0);
+	frameTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameTime_));
+	spinTime = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spinTime_));
+	wait = wait_;
+	maxLagFrames = maxLagFrames_;
+	lastJitter = 0.;
+	sumJitter = 0.;
+	maxJitter = 0.;
+	frameCount = 0;
+	resyncCount = 0;
+	memset(jitterHistory, 0, sizeof(jitterHistory));
+	deadline = Clock::now() + frameTime;
+}
+
+
+void FramePacer::Restart()
+{
+	deadline = Clock::now() + frameTime;
+}
+
+
+void FramePacer::WaitNextFrame()
+{
+	Clock::time_point now = Clock::now();
+	if (now > deadline + frameTime * maxLagFrames)
+	{
+		// Too far behind (e.g. a breakpoint), start over instead of presenting frames back to back
+		deadline = now;
+		++resyncCount;
+	}
+	else
+	{
+		WaitUntil(deadline);
+		now = Clock::now();
+	}
+
+	lastJitter = std::chrono::duration<double>(now - deadline).count();
+	sumJitter += std::abs(lastJitter);
+	maxJitter = std::max(maxJitter, std::abs(lastJitter));
+	jitterHistory[frameCount % historySize] = (float)lastJitter;
+	++frameCount;
+	// Drift correction: the next deadline depends on the schedule only
+	deadline += frameTime;
+}
+
+
+double FramePacer::GetLastJitter() const
+{
+	return lastJitter;
+}
+
+
+double FramePacer::GetMeanJitter() const
+{
+	return frameCount ? sumJitter / (double)frameCount : 0.;
+}
+
+
+double FramePacer::GetMaxJitter() const
+{
+	return maxJitter;
+}
+
+
+uint64 FramePacer::GetFrameCount() const
+{
+	return frameCount;
+}
+
+
+uint64 FramePacer::GetResyncCount() const
+{
+	return resyncCount;
+}
+
+
+int FramePacer::GetJitterHistory(float* jitter) const
+{
+	const int count = (int)std::min<uint64>(frameCount, historySize);
+	for (int i = 0; i < count; ++i)
+	{
+		jitter[i] = jitterHistory[(frameCount - count + i) % historySize];
+	}
+	return count;
+}
+
+
+void FramePacer::WaitUntil(Clock::time_point t)
+{
+	if (wait == FrameWait::sleep)
+	{
+		SleepUntil(t);
+		return;
+	}
+	if (wait == FrameWait::hybrid && Clock::now() < t - spinTime)
+	{
+		SleepUntil(t - spinTime);
+	}
+	while (Clock::now() < t)
+	{
+		CPU_RELAX();
+	}
+}
+
+
+void FramePacer::SleepUntil(Clock::time_point t)
+{
+#if defined(_WIN32)
+	const auto now = Clock::now();
+	if (t <= now)
+	{
+		return;
+	}
+	if (timer)
+	{
+		// Relative due time in 100 ns units. Waitable timers only take absolute times in system time,
+		// which is not monotonic
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -std::max<long long>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(t - now).count() / 100);
+		if (SetWaitableTimer(timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(timer, INFINITE);
+			return;
+		}
+	}
+	std::this_thread::sleep_until(t);
+#else
+	// steady_clock is CLOCK_MONOTONIC, the absolute wait is not affected by the time spent before it
+	const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+	timespec ts;
+	ts.tv_sec = (time_t)(ns / 1000000000);
+	ts.tv_nsec = (long)(ns % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+	{
+	}
+#endif
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Base.h"
+#include <chrono>
+
+
+enum class FrameWait
+{
+	sleep,  // OS wait only, cheapest but wakes up late by the timer resolution
+	hybrid, // OS wait until spinTime before the deadline, then spin
+	spin    // busy wait, most accurate, burns one core
+};
+
+// sleep, hybrid or spin. hybrid if the name is unknown
+FrameWait GetFrameWait(const char* name);
+
+
+// Paces frames to absolute deadlines. Deadlines advance by exactly one frame time from the previous
+// deadline, not from the time the frame ended, so waking up late does not delay the next frames.
+// When the game falls behind by more than maxLagFrames the schedule restarts from the current time
+// instead of rushing frames to catch up
+class FramePacer
+{
+public:
+
+	FramePacer();
+	~FramePacer();
+	FramePacer(const FramePacer&) = delete;
+	FramePacer& operator=(const FramePacer&) = delete;
+
+	// frameTime and spinTime in seconds
+	void Start(double frameTime, FrameWait wait, double spinTime, int maxLagFrames = 4);
+	// Waits for the deadline of the current frame
+	void WaitNextFrame();
+	// Starts the schedule over from the current time, after the caller waited on its own (idle states)
+	void Restart();
+
+	// Jitter: wake up time minus deadline in seconds, positive if late
+	double GetLastJitter() const;
+	double GetMeanJitter() const;  // mean of the absolute jitter
+	double GetMaxJitter() const;
+	uint64 GetFrameCount() const;
+	uint64 GetResyncCount() const; // times the schedule was restarted
+	// Jitter of the last frames, oldest first
+	static constexpr int historySize = 256;
+	int GetJitterHistory(float* jitter) const;
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	void WaitUntil(Clock::time_point deadline);
+	void SleepUntil(Clock::time_point deadline);
+
+	Clock::time_point deadline;
+	Clock::duration   frameTime;
+	Clock::duration   spinTime;
+	FrameWait         wait;
+	int               maxLagFrames;
+	// Jitter statistics
+	double            lastJitter;
+	double            sumJitter;
+	double            maxJitter;
+	uint64            frameCount;
+	uint64            resyncCount;
+	float             jitterHistory[historySize];
+	void*             timer; // high resolution waitable timer on Windows
+};
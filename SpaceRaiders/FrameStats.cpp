@@ -0,0 +1,314 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+
+namespace
+{
+
+const char* const metricNames[(int)FrameMetric::count] =
+{
+	"frame",
+	"tick",
+	"render",
+	"present",
+	"sleep"
+};
+
+volatile std::sig_atomic_t statsSignal = 0;
+
+
+void OnStatsSignal(int)
+{
+	statsSignal = 1;
+}
+
+
+uint32 ToMicroseconds(double seconds)
+{
+	const double us = seconds * 1e6 + .5;
+	return us <= 0. ? 0 : us >= 4294967295. ? 0xFFFFFFFF : (uint32)us;
+}
+
+
+int FloorLog2(uint32 v)
+{
+	int n = 0;
+	while (v >>= 1)
+	{
+		++n;
+	}
+	return n;
+}
+
+}
+
+
+TimeHistogram::TimeHistogram()
+{
+	Clear();
+}
+
+
+void TimeHistogram::Clear()
+{
+	memset(counts, 0, sizeof(counts));
+	count = 0;
+	sum = 0;
+}
+
+
+void TimeHistogram::Add(uint32 us)
+{
+	++counts[GetBucket(us)];
+	++count;
+	sum += us;
+}
+
+
+void TimeHistogram::Remove(uint32 us)
+{
+	const int bucket = GetBucket(us);
+	assert(counts[bucket] > 0);
+	--counts[bucket];
+	--count;
+	sum -= us;
+}
+
+
+uint64 TimeHistogram::GetCount() const
+{
+	return count;
+}
+
+
+double TimeHistogram::GetMean() const
+{
+	return count ? (double)sum / (double)count : 0.;
+}
+
+
+uint32 TimeHistogram::GetPercentile(double p) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	const uint64 rank = std::max<uint64>(1, (uint64)std::ceil(std::min(100., std::max(0., p)) / 100. * (double)count));
+	uint64 n = 0;
+	for (int b = 0; b < numBuckets; ++b)
+	{
+		n += counts[b];
+		if (n >= rank)
+		{
+			return GetBucketUpperBound(b);
+		}
+	}
+	return GetMaxBound();
+}
+
+
+uint32 TimeHistogram::GetMaxBound() const
+{
+	for (int b = numBuckets - 1; b >= 0; --b)
+	{
+		if (counts[b])
+		{
+			return GetBucketUpperBound(b);
+		}
+	}
+	return 0;
+}
+
+
+int TimeHistogram::GetBucket(uint32 us)
+{
+	if (us < numSubBuckets)
+	{
+		return (int)us;
+	}
+	const int shift = FloorLog2(us) - subBits;
+	return numSubBuckets + shift * numSubBuckets + (int)((us >> shift) - numSubBuckets);
+}
+
+
+uint32 TimeHistogram::GetBucketUpperBound(int bucket)
+{
+	assert(bucket >= 0 && bucket < numBuckets);
+	if (bucket < numSubBuckets)
+	{
+		return (uint32)bucket;
+	}
+	const int shift = (bucket - numSubBuckets) / numSubBuckets;
+	const uint32 sub = (uint32)((bucket - numSubBuckets) % numSubBuckets);
+	return (uint32)((((uint64)(numSubBuckets + sub) << shift) + ((uint64)1 << shift) - 1));
+}
+
+
+const char* GetFrameMetricName(FrameMetric metric)
+{
+	assert((int)metric >= 0 && metric < FrameMetric::count);
+	return metricNames[(int)metric];
+}
+
+
+FrameStats::FrameStats() :
+	budgetUs { 0 },
+	windowSize { 0 }
+{
+	Start(1. / 60., 300);
+}
+
+
+void FrameStats::Start(double budget, int windowSize_)
+{
+	assert(budget > 0.);
+	assert(windowSize_ > 0);
+	budgetUs = ToMicroseconds(budget);
+	windowSize = windowSize_;
+	for (Series& s : series)
+	{
+		s.total.Clear();
+		s.window.Clear();
+		s.samples.clear();
+		s.samples.reserve(windowSize);
+		s.next = 0;
+		s.totalMax = 0;
+		s.totalOver = 0;
+		s.windowOver = 0;
+	}
+}
+
+
+void FrameStats::Record(FrameMetric metric, double seconds)
+{
+	assert((int)metric >= 0 && metric < FrameMetric::count);
+	Series& s = series[(int)metric];
+	const uint32 us = ToMicroseconds(seconds);
+	const bool over = us > budgetUs;
+	s.total.Add(us);
+	s.totalMax = std::max(s.totalMax, us);
+	s.totalOver += over;
+	// Rolling window: the oldest sample leaves the histogram when the ring is full
+	if ((int)s.samples.size() < windowSize)
+	{
+		s.samples.push_back(us);
+	}
+	else
+	{
+		const uint32 old = s.samples[s.next];
+		s.window.Remove(old);
+		s.windowOver -= (old > budgetUs);
+		s.samples[s.next] = us;
+	}
+	s.next = (s.next + 1) % windowSize;
+	s.window.Add(us);
+	s.windowOver += over;
+}
+
+
+FrameStats::Summary FrameStats::GetSummary(FrameMetric metric, bool window) const
+{
+	assert((int)metric >= 0 && metric < FrameMetric::count);
+	const Series& s = series[(int)metric];
+	const TimeHistogram& h = window ? s.window : s.total;
+	Summary summary;
+	// Exact maximum, the histogram only knows its bucket. Percentiles are bucket upper bounds, clamped to it
+	const uint32 max = window ? (s.samples.empty() ? 0 : *std::max_element(s.samples.begin(), s.samples.end())) : s.totalMax;
+	summary.count = h.GetCount();
+	summary.mean = h.GetMean() * 1e-6;
+	summary.p50 = std::min(max, h.GetPercentile(50.)) * 1e-6;
+	summary.p95 = std::min(max, h.GetPercentile(95.)) * 1e-6;
+	summary.p99 = std::min(max, h.GetPercentile(99.)) * 1e-6;
+	summary.max = max * 1e-6;
+	summary.overBudget = window ? (uint64)s.windowOver : s.totalOver;
+	return summary;
+}
+
+
+double FrameStats::GetBudget() const
+{
+	return budgetUs * 1e-6;
+}
+
+
+bool FrameStats::Write(const char* fileName) const
+{
+	const size_t len = strlen(fileName);
+	if (len >= 5 && !strcmp(fileName + len - 5, ".json"))
+	{
+		return WriteJSON(fileName);
+	}
+	return WriteCSV(fileName);
+}
+
+
+bool FrameStats::WriteCSV(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "metric,scope,count,mean_us,p50_us,p95_us,p99_us,max_us,over_budget,budget_us\n");
+	for (int m = 0; m < (int)FrameMetric::count; ++m)
+	{
+		for (int w = 0; w < 2; ++w)
+		{
+			const Summary s = GetSummary((FrameMetric)m, w == 1);
+			fprintf(file, "%s,%s,%llu,%.1f,%.0f,%.0f,%.0f,%.0f,%llu,%u\n", metricNames[m], w ? "window" : "total", (unsigned long long)s.count,
+				s.mean * 1e6, s.p50 * 1e6, s.p95 * 1e6, s.p99 * 1e6, s.max * 1e6, (unsigned long long)s.overBudget, budgetUs);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+
+bool FrameStats::WriteJSON(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "{\n  \"budget_us\": %u,\n  \"window_frames\": %d,\n  \"metrics\": {\n", budgetUs, windowSize);
+	for (int m = 0; m < (int)FrameMetric::count; ++m)
+	{
+		fprintf(file, "    \"%s\": {\n", metricNames[m]);
+		for (int w = 0; w < 2; ++w)
+		{
+			const Summary s = GetSummary((FrameMetric)m, w == 1);
+			fprintf(file, "      \"%s\": { \"count\": %llu, \"mean_us\": %.1f, \"p50_us\": %.0f, \"p95_us\": %.0f, \"p99_us\": %.0f, \"max_us\": %.0f, \"over_budget\": %llu }%s\n",
+				w ? "window" : "total", (unsigned long long)s.count, s.mean * 1e6, s.p50 * 1e6, s.p95 * 1e6, s.p99 * 1e6, s.max * 1e6,
+				(unsigned long long)s.overBudget, w ? "" : ",");
+		}
+		fprintf(file, "    }%s\n", m + 1 < (int)FrameMetric::count ? "," : "");
+	}
+	fprintf(file, "  }\n}\n");
+	return fclose(file) == 0;
+}
+
+
+void InstallStatsSignal()
+{
+#if defined(SIGUSR1)
+	std::signal(SIGUSR1, OnStatsSignal);
+#elif defined(SIGBREAK)
+	std::signal(SIGBREAK, OnStatsSignal);
+#endif
+}
+
+
+bool TakeStatsSignal()
+{
+	if (statsSignal)
+	{
+		statsSignal = 0;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Base.h"
+#include <vector>
+
+
+// Histogram of durations in microseconds with a bounded relative error, as HDR histograms. Values
+// below 2^subBits us have their own bucket, larger values share 2^subBits buckets per power of two,
+// so percentiles are accurate to 1 / 2^subBits whatever the magnitude of the values
+class TimeHistogram
+{
+public:
+
+	static constexpr int subBits = 5; // ~3% precision
+	static constexpr int numSubBuckets = 1 << subBits;
+	static constexpr int numBuckets = numSubBuckets + (32 - subBits) * numSubBuckets;
+
+	TimeHistogram();
+
+	void Clear();
+	void Add(uint32 us);
+	// Removes a value added before
+	void Remove(uint32 us);
+
+	uint64 GetCount() const;
+	double GetMean() const;
+	// Upper bound of the bucket holding the p-th percentile, p in [0, 100]
+	uint32 GetPercentile(double p) const;
+	// Upper bound of the highest non empty bucket
+	uint32 GetMaxBound() const;
+
+	static int GetBucket(uint32 us);
+	static uint32 GetBucketUpperBound(int bucket);
+
+private:
+
+	uint32 counts[numBuckets];
+	uint64 count;
+	uint64 sum;
+};
+
+
+enum class FrameMetric
+{
+	frame,   // whole frame, from frame start to frame start
+	tick,    // all simulation steps of the frame
+	render,  // drawing the canvas
+	present, // sending the canvas to the presenters
+	sleep,   // waiting for the next frame
+	count
+};
+
+const char* GetFrameMetricName(FrameMetric metric);
+
+
+// Frame time statistics. Every metric is tracked over the whole run and over a rolling window of the
+// last frames, with the number of frames over the frame budget
+class FrameStats
+{
+public:
+
+	struct Summary
+	{
+		uint64 count;
+		double mean; // [s]
+		double p50;
+		double p95;
+		double p99;
+		double max;
+		uint64 overBudget; // samples longer than the frame budget
+	};
+
+	FrameStats();
+
+	// budget: frame time [s], windowSize: frames of the rolling window
+	void Start(double budget, int windowSize);
+	void Record(FrameMetric metric, double seconds);
+
+	// window: rolling window or whole run
+	Summary GetSummary(FrameMetric metric, bool window) const;
+	double GetBudget() const;
+
+	// .json files are written as JSON, other files as CSV
+	bool Write(const char* fileName) const;
+	bool WriteCSV(const char* fileName) const;
+	bool WriteJSON(const char* fileName) const;
+
+private:
+
+	struct Series
+	{
+		TimeHistogram       total;
+		TimeHistogram       window;
+		std::vector<uint32> samples; // ring buffer of the window
+		int                 next;    // next slot of the ring
+		uint32              totalMax;
+		uint64              totalOver;
+		int                 windowOver;
+	};
+
+	Series series[(int)FrameMetric::count];
+	uint32 budgetUs;
+	int    windowSize;
+};
+
+
+// Dump requests from outside: SIGUSR1 on Linux, Ctrl+Break on Windows
+void InstallStatsSignal();
+// True once per signal received since the last call
+bool TakeStatsSignal();
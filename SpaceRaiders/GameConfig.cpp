@@ -1,4 +1,9 @@
 #include "GameConfig.h"
+#include "inih-master/ini.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 
 // Game configuration
@@ -6,9 +11,15 @@ GameConfig::GameConfig()
 {
 	// Console
 	fontSize = 12;
+	terminalOutput = false;
+	renderThreads = 0;
+	halfBlocks = false;
 	// World
 	worldWidth = 160;
 	worldHeight = 54;
+	viewWidth = 0;
+	viewHeight = 0;
+	cameraFollow = true;
 	maxAlienLasers = 10;
 	maxPlayerLasers = 4;
 	// Player
@@ -35,4 +46,127 @@ GameConfig::GameConfig()
 
 	godMode = false;  // good for testing
 	randomSeed = 1734176512;
+	simulationRate = 62.5f;  // 16 ms
+	presentationRate = 62.5f;
+	timeScale = 1.f;
+	catchUpSteps = 1;
+	decimationScale = 8.f;
+	frameBudget = true;
+	maxSkippedFrames = 2;
+	budgetLog[0] = 0;
+	strcpy(frameWait, "hybrid");
+	frameSpinTime = 0.5f;
+	idleWait = true;
+	maxIdleWait = 250.f;
+	parallelStep = false;
+	taskLog[0] = 0;
+	statsFile[0] = 0;
+	statsWindow = 300;
+	profileFile[0] = 0;
+	assetPack[0] = 0;
+	watchAssets[0] = 0;
+	portraitImage[0] = 0;
+	introVideo[0] = 0;
+	victoryVideo[0] = 0;
+	captureFile[0] = 0;
+	strcpy(captureFormat, "asciicast");
+	sharedFrames[0] = 0;
+	sharedFrameSlots = 4;
+}
+
+
+namespace
+{
+
+#define PARSE_INT(varName, minv, maxv) \
+	if (!strcmp(name, #varName)) \
+	{ \
+		config.varName = std::max(minv, std::min(maxv, std::atoi(value))); \
+	}
+
+#define PARSE_FLOAT(varName, minv, maxv) \
+	do { \
+		if (!strcmp(name, #varName)) \
+		{ \
+			config.varName = std::max(minv, std::min(maxv, (float)std::atof(value))); \
+		} \
+	} while(0)
+
+#define PARSE_STRING(varName) \
+	if (!strcmp(name, #varName)) \
+	{ \
+		snprintf(config.varName, sizeof(config.varName), "%s", value); \
+	}
+
+#define PARSE_BOOL(varName) \
+	if (!strcmp(name, #varName)) \
+	{ \
+		config.varName = strcmp(value, "true") ? false : true; \
+	}
+
+int INIParser(void* user, const char* section, const char* name, const char* value)
+{
+	GameConfig& config = *(GameConfig*)user;
+	PARSE_INT(worldWidth, 40, 2000);
+	PARSE_INT(worldHeight, 20, 1000);
+	PARSE_INT(viewWidth, 0, 2000);
+	PARSE_INT(viewHeight, 0, 1000);
+	PARSE_BOOL(cameraFollow);
+	PARSE_INT(maxAlienLasers, 0, 100);
+	PARSE_INT(maxPlayerLasers, 0, 100);
+	PARSE_FLOAT(playerFireRate, 0.f, 1000.f);
+	PARSE_FLOAT(playerLaserVelocity, 0.f, 1000.f);
+	PARSE_BOOL(godMode);
+	PARSE_BOOL(terminalOutput);
+	PARSE_INT(renderThreads, 0, 64);
+	PARSE_BOOL(halfBlocks);
+	PARSE_FLOAT(alienSpeedMul, 0.f, 100.f);
+	PARSE_FLOAT(alienLaserVelocity, 0.f, 1000.f);
+	PARSE_FLOAT(alienTransformEnergy, 0.f, 1000.f);
+	PARSE_FLOAT(alienDownVelocity, 0.f, 1000.f);
+	PARSE_FLOAT(alienFireRate, 0.f, 1000.f);
+	PARSE_FLOAT(betterAlienFireRate, 0.f, 1000.f);
+	PARSE_FLOAT(explosionTimer, 0.f, 100.f);
+	PARSE_FLOAT(powerUpVelocity, 0.f, 100.f);
+	PARSE_INT(powerUpHits, 0, 100);
+	PARSE_FLOAT(powerUpFireBoost, 1.f, 10.f);
+	PARSE_FLOAT(simulationRate, 1.f, 1000.f);
+	PARSE_FLOAT(presentationRate, 1.f, 1000.f);
+	PARSE_FLOAT(timeScale, 1.f / 16.f, 64.f);
+	PARSE_INT(catchUpSteps, 0, 1000);
+	PARSE_FLOAT(decimationScale, 0.f, 64.f);
+	PARSE_BOOL(frameBudget);
+	PARSE_INT(maxSkippedFrames, 0, 60);
+	PARSE_STRING(budgetLog);
+	PARSE_STRING(frameWait);
+	PARSE_FLOAT(frameSpinTime, 0.f, 20.f);
+	PARSE_BOOL(idleWait);
+	PARSE_FLOAT(maxIdleWait, 10.f, 5000.f);
+	PARSE_BOOL(parallelStep);
+	PARSE_STRING(taskLog);
+	PARSE_STRING(statsFile);
+	PARSE_INT(statsWindow, 1, 100000);
+	PARSE_STRING(profileFile);
+	PARSE_STRING(assetPack);
+	PARSE_STRING(watchAssets);
+	PARSE_STRING(portraitImage);
+	PARSE_STRING(introVideo);
+	PARSE_STRING(victoryVideo);
+	PARSE_STRING(captureFile);
+	PARSE_STRING(captureFormat);
+	PARSE_STRING(sharedFrames);
+	PARSE_INT(sharedFrameSlots, 2, 64);
+	return 1;
+}
+#undef PARSE_FLOAT
+#undef PARSE_INT
+#undef PARSE_BOOL
+#undef PARSE_STRING
+
+}
+
+
+void ReadGameConfig(GameConfig& config, const char* iniFileName)
+{
+	ini_parse(iniFileName, INIParser, &config);
 }
@@ -5,9 +5,15 @@ struct GameConfig
 {
 	// Console
 	int   fontSize;
+	bool  terminalOutput; // write VT escape sequences instead of using the console API
+	int   renderThreads;  // threads rasterizing large canvases, 0: one per hardware thread, 1: no worker threads
+	bool  halfBlocks;     // sprites move by half rows, packed into half block glyphs
 	// World
 	int   worldWidth;
 	int   worldHeight;
+	int   viewWidth;    // visible part of the world, 0: whole world
+	int   viewHeight;
+	bool  cameraFollow; // scroll the view to follow the players
 	int   maxAlienLasers;
 	int   maxPlayerLasers;
 	// Player
@@ -34,6 +40,38 @@ struct GameConfig
 	// Simulation
 	bool godMode;  // good for testing
 	unsigned int randomSeed; // > 0 to specify a fixed random seed for testing
+	float simulationRate;   // simulation steps per second
+	float presentationRate; // presented frames per second, positions are interpolated between simulation steps
+	float timeScale;        // simulation seconds per real second at start, changed with Page Up/Down, Home resets
+	int   catchUpSteps;     // simulation steps a frame may run beyond its share to catch up, more are dropped
+	float decimationScale;  // above this time scale, frames are rendered less often, 0: always render
+	bool  frameBudget;      // degrade rendering to fit the frame time instead of dropping simulation steps
+	int   maxSkippedFrames; // frames the scheduler may skip in a row
+	char  budgetLog[256];   // frames degraded by the scheduler written at exit if not empty, CSV
+	char  frameWait[16];    // wait for the next frame: sleep, hybrid or spin
+	float frameSpinTime;    // [ms] hybrid wait: spin for the end of the wait instead of sleeping
+	bool  idleWait;         // idle states (menus, pause) wait for input or their next change instead of running every frame
+	float maxIdleWait;      // [ms] longest idle wait, bounds the latency of asset reloading and of the stats signal
+	bool  parallelStep;     // run the independent stages of a simulation step on the render threads
+	char  taskLog[256];     // time of every step stage and critical path per frame if not empty, CSV
+	char  statsFile[256];   // frame time statistics written at exit and on SIGUSR1 (Ctrl+Break on Windows), .json or CSV
+	int   statsWindow;      // frames of the rolling statistics window
+	char  profileFile[256]; // Chrome trace of the profiler zones written at exit, builds with PROFILER=1 only
+	// Assets
+	char assetPack[256];     // images of this pack replace the built-in ones if not empty
+	char watchAssets[256];   // reload images from the text files of this directory when they change
+	char portraitImage[256]; // PGM or PPM picture shown as ASCII art on the victory screen
+	char introVideo[256];    // ASCII videos made with --make-video, played by the intro and victory screens
+	char victoryVideo[256];
+	// Capture
+	char captureFile[256];   // record all presented frames to this file if not empty
+	char captureFormat[16];  // text, asciicast or digest
+	char sharedFrames[64];   // publish all presented frames to this shared memory ring if not empty
+	int  sharedFrameSlots;
 
 	GameConfig();
 };
+
+
+// Overrides the defaults with the values of an ini file, see game.ini
+void ReadGameConfig(GameConfig& config, const char* iniFileName);
@@ -0,0 +1,45 @@
+#include "GameStates.h"
+#include "Game.h"
+#include "StartMenu.h"
+#include "PauseScreen.h"
+#include "PlayGameState.h"
+#include "GameOverState.h"
+#include "IntroScreen.h"
+#include "VictoryScreen.h"
+#include <cassert>
+
+
+namespace
+{
+
+const char* const stateNames[(int)GameStateId::count] =
+{
+	"start",
+	"intro",
+	"running",
+	"paused",
+	"over",
+	"victory",
+	"quit"
+};
+
+}
+
+
+void RegisterGameStates(Game& game)
+{
+	RegisterGameState(game, &startMenuData, StartMenu, DisplayStartMenu, EnterStartMenu, WakeStartMenu);
+	RegisterGameState(game, &introScreenData, IntroScreen, DisplayIntroScreen, EnterIntroScreen, WakeIntroScreen);
+	RegisterGameState(game, &playGameStateData, PlayGame, DisplayPlayGame, EnterPlayGame);
+	RegisterGameState(game, nullptr, PauseScreen, DisplayPauseScreen, nullptr, WakePauseScreen);
+	RegisterGameState(game, nullptr, GameOverMenu, DisplayGameOver, nullptr, WakeGameOver);
+	RegisterGameState(game, &victoryScreenData, VictoryScreen, DisplayVictoryScreen, EnterVictoryScreen, WakeVictoryScreen);
+	RegisterGameState(game, nullptr, nullptr, nullptr, nullptr);
+}
+
+
+const char* GetGameStateName(GameStateId id)
+{
+	assert(id >= GameStateId::start && id < GameStateId::count);
+	return stateNames[(int)id];
+}
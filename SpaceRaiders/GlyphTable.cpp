@@ -0,0 +1,182 @@
+#include "GlyphTable.h"
+#include "Image.h"
+#include "Images.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <chrono>
+
+
+namespace
+{
+
+constexpr int maxPages = 32;
+
+GlyphUTF8        pages[maxPages][256];
+const GlyphUTF8* pageTable[256]; // indexed by the high byte of a glyph, null if the page has not been encoded yet
+int              numPages = 0;
+GlyphUTF8 fallback; // used when the table is full
+
+
+bool AddPage(int high)
+{
+	if (numPages == maxPages)
+	{
+		return false;
+	}
+	GlyphUTF8* page = pages[numPages];
+	for (int low = 0; low < 256; ++low)
+	{
+		page[low].length = (uint8)EncodeUTF8((uint16)((high << 8) | low), page[low].bytes);
+	}
+	pageTable[high] = page;
+	++numPages;
+	return true;
+}
+
+
+void RegisterGlyph(uint16 ch)
+{
+	if (! pageTable[ch >> 8])
+	{
+		AddPage(ch >> 8);
+	}
+}
+
+}
+
+
+int EncodeUTF8(uint16 ch, char* out)
+{
+	if (ch < 0x80)
+	{
+		out[0] = (char)ch;
+		return 1;
+	}
+	else if (ch < 0x800)
+	{
+		out[0] = (char)(0xC0 | (ch >> 6));
+		out[1] = (char)(0x80 | (ch & 0x3F));
+		return 2;
+	}
+	out[0] = (char)(0xE0 | (ch >> 12));
+	out[1] = (char)(0x80 | ((ch >> 6) & 0x3F));
+	out[2] = (char)(0x80 | (ch & 0x3F));
+	return 3;
+}
+
+
+void InitGlyphTable()
+{
+	RegisterGlyph(' '); // ASCII
+	for (size_t i = 0; i < numImages; ++i)
+	{
+		RegisterGlyphs(GetImage((ImageId)i));
+	}
+}
+
+
+void RegisterGlyphs(const wchar_t* str)
+{
+	assert(str);
+	for (; *str; ++str)
+	{
+		RegisterGlyph((uint16)*str);
+	}
+}
+
+
+void RegisterGlyphs(const Image& image)
+{
+	if (image.img)
+	{
+		RegisterGlyphs(image.img);
+	}
+}
+
+
+const GlyphUTF8& GetGlyphUTF8(uint16 ch)
+{
+	const GlyphUTF8* page = pageTable[ch >> 8];
+	if (! page)
+	{
+		if (! AddPage(ch >> 8))
+		{
+			fallback.length = (uint8)EncodeUTF8(ch, fallback.bytes);
+			return fallback;
+		}
+		page = pageTable[ch >> 8];
+	}
+	return page[ch & 0xFF];
+}
+
+
+int CopyGlyphUTF8(uint16 ch, char* out)
+{
+	const GlyphUTF8& glyph = GetGlyphUTF8(ch);
+	memcpy(out, &glyph, sizeof(glyph));
+	return glyph.length;
+}
+
+
+void RunGlyphBenchmark(int cols, int rows, int numFrames)
+{
+	assert(cols > 0 && rows > 0 && numFrames > 0);
+	// Fill the canvas with the glyphs of all the images
+	std::vector<uint16> glyphs;
+	for (size_t i = 0; i < numImages; ++i)
+	{
+		const Image& image = GetImage((ImageId)i);
+		for (const wchar_t* s = image.img; s && *s; ++s)
+		{
+			if (*s != '\n')
+			{
+				glyphs.push_back((uint16)*s);
+			}
+		}
+	}
+	if (glyphs.empty())
+	{
+		glyphs.push_back(' ');
+	}
+	const size_t numCells = (size_t)cols * rows;
+	std::vector<uint16> canvas(numCells);
+	for (size_t i = 0; i < numCells; ++i)
+	{
+		canvas[i] = glyphs[i % glyphs.size()];
+	}
+
+	// One spare byte, glyphs are always copied 4 bytes at a time
+	std::vector<char> out(numCells * 3 + 1);
+	size_t totalBytes = 0;
+	using clock = std::chrono::steady_clock;
+
+	auto t0 = clock::now();
+	for (int f = 0; f < numFrames; ++f)
+	{
+		char* dst = out.data();
+		for (uint16 ch : canvas)
+		{
+			dst += EncodeUTF8(ch, dst);
+		}
+		totalBytes += dst - out.data();
+	}
+	auto t1 = clock::now();
+	for (int f = 0; f < numFrames; ++f)
+	{
+		char* dst = out.data();
+		for (uint16 ch : canvas)
+		{
+			dst += CopyGlyphUTF8(ch, dst);
+		}
+		totalBytes += dst - out.data();
+	}
+	auto t2 = clock::now();
+
+	const double encodeTime = std::chrono::duration<double, std::micro>(t1 - t0).count() / numFrames;
+	const double tableTime = std::chrono::duration<double, std::micro>(t2 - t1).count() / numFrames;
+	printf("Glyph encoding, %dx%d canvas, %d frames, %zu bytes per frame\n", cols, rows, numFrames, totalBytes / (2 * numFrames));
+	printf("  EncodeUTF8:   %8.2f us/frame\n", encodeTime);
+	printf("  Glyph table:  %8.2f us/frame\n", tableTime);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Base.h"
+
+struct Image;
+
+
+// UTF-8 encoding of a glyph
+struct GlyphUTF8
+{
+	char  bytes[3];
+	uint8 length;
+};
+static_assert(sizeof(GlyphUTF8) == 4, "GlyphUTF8 must be 4 bytes");
+
+
+// Writes the UTF-8 encoding of ch to out (at least 3 bytes). Returns the number of bytes written
+int EncodeUTF8(uint16 ch, char* out);
+
+// Pre-encodes the glyphs of all the images. The table is made of pages of 256 glyphs, a page is
+// encoded as soon as one of its glyphs is used
+void InitGlyphTable();
+void RegisterGlyphs(const wchar_t* str);
+void RegisterGlyphs(const Image& image);
+// Glyphs not registered in advance are added to the table on first use
+const GlyphUTF8& GetGlyphUTF8(uint16 ch);
+// Copies the 4 bytes of the table entry to out and returns the glyph length. Cheaper than copying
+// exactly length bytes, out must have room for 4 bytes
+int CopyGlyphUTF8(uint16 ch, char* out);
+
+// Micro-benchmark: encodes numFrames canvases filled with image glyphs, with and without the table
+void RunGlyphBenchmark(int cols, int rows, int numFrames);
@@ -0,0 +1,106 @@
+#include "Headless.h"
+#include "Base.h"
+#include "GameConfig.h"
+#include "Game.h"
+#include "GameStates.h"
+#include "PlayField.h"
+#include "PlayGameState.h"
+#include "TaskGraph.h"
+#include "WorkerPool.h"
+#include "MessageLog.h"
+#include "Profiler.h"
+#include "src/ScriptModule.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+
+namespace
+{
+
+const char* const modeNames[] =
+{
+	"p1",
+	"cpu1",
+	"p1p2",
+	"p1cpu2",
+	"cpu1cpu2"
+};
+
+bool ParseMode(const char* name, Game::Mode& mode)
+{
+	for (int i = 0; i < (int)_countof(modeNames); ++i)
+	{
+		if (!strcmp(name, modeNames[i]))
+		{
+			mode = (Game::Mode)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+}
+
+
+int RunHeadless(const GameConfig& baseConfig, const ScriptModule& scriptModule, int numArgs, char* args[])
+{
+	Game::Mode mode;
+	if (numArgs < 1 || !ParseMode(args[0], mode))
+	{
+		fprintf(stderr, "Expected mode [seed [ticks]], modes: p1, cpu1, p1p2, p1cpu2, cpu1cpu2\n");
+		return 1;
+	}
+	GameConfig config = baseConfig;
+	const uint seed = numArgs > 1 ? (uint)strtoul(args[1], nullptr, 10) : 0;
+	if (seed)
+	{
+		config.randomSeed = seed;
+	}
+	const uint64 maxTicks = numArgs > 2 ? strtoull(args[2], nullptr, 10) : 0;
+
+	std::default_random_engine rGen;
+	MessageLog messageLog;
+	const Vector2D worldSize { (float)config.worldWidth, (float)config.worldHeight };
+	PlayField world { worldSize, config, rGen, messageLog };
+	Game game = NewGame(world, config, rGen, messageLog, scriptModule);
+	RegisterGameStates(game);
+	WorkerPool workers { config.parallelStep ? config.renderThreads : 1 };
+	game.workers = &workers;
+	TaskGraph& stepTasks = GetPlayGameTasks();
+	if (config.taskLog[0] && !stepTasks.StartLog(config.taskLog))
+	{
+		fprintf(stderr, "Can't write %s\n", config.taskLog);
+	}
+
+	// Straight to the game, skipping the menu and the intro
+	game.mode = mode;
+	EnterGameState(game, (int)GameStateId::running);
+	const float fixedDeltaTime = 1.f / config.simulationRate;
+	uint64 ticks = 0;
+	PROFILE_THREAD("Headless");
+	const auto t0 = std::chrono::steady_clock::now();
+	while (game.stateId == (int)GameStateId::running && (maxTicks == 0 || ticks < maxTicks))
+	{
+		RunGameState(game, fixedDeltaTime);
+		messageLog.DeleteOldMessages(fixedDeltaTime, 3.f);
+		stepTasks.EndFrame();
+		++ticks;
+	}
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+	printf("mode %s, seed %u\n", modeNames[(int)mode], config.randomSeed);
+	printf("%llu ticks (%.1f s of game time), state: %s\n", (unsigned long long)ticks, ticks * fixedDeltaTime, GetGameStateName((GameStateId)game.stateId));
+	for (int p = 0; p < game.numPlayers; ++p)
+	{
+		printf("P%d score: %d\n", p + 1, game.score[p]);
+	}
+	printf("%.3f s, %.0f ticks/s, %.2f us/tick\n", elapsed, elapsed > 0. ? ticks / elapsed : 0., ticks ? elapsed * 1e6 / ticks : 0.);
+	if (config.profileFile[0] && !WriteProfileTrace(config.profileFile))
+	{
+		fprintf(stderr, "Can't write %s (profiler compiled out?)\n", config.profileFile);
+	}
+	return 0;
+}
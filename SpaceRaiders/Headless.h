@@ -0,0 +1,13 @@
+#pragma once
+
+
+struct GameConfig;
+struct ScriptModule;
+
+
+// Plays a game without console, input or waits, as fast as the CPU allows, then prints the final
+// scores and the timing. args: mode [seed [ticks]]
+// mode: p1, cpu1, p1p2, p1cpu2 or cpu1cpu2, only the cpu players play
+// seed: 0 keeps randomSeed of the config
+// ticks: maximum number of simulation steps, 0 runs until game over or victory
+int RunHeadless(const GameConfig& config, const ScriptModule& scriptModule, int numArgs, char* args[]);
@@ -0,0 +1,26 @@
+#include "Headless.h"
+#include "GameConfig.h"
+#include "Images.h"
+#include "src/ScriptModule.h"
+#include <cstdio>
+#include <cstring>
+
+
+// Entry point of the headless executable for platforms without the Win32 console, see CMakeLists.txt.
+// Takes the same arguments as SpaceRaiders --headless
+int main(int argc, char* argv[])
+{
+	GameConfig gameConfig;
+	ReadGameConfig(gameConfig, "game.ini");
+	if (gameConfig.assetPack[0] && !LoadAssetPack(gameConfig.assetPack))
+	{
+		fprintf(stderr, "Can't load asset pack %s\n", gameConfig.assetPack);
+	}
+	ScriptModule scriptModule;
+	if (!InitScriptModule(scriptModule, "Scripts.dll"))
+	{
+		return 1;
+	}
+	const int first = (argc > 1 && !strcmp(argv[1], "--headless")) ? 2 : 1;
+	return RunHeadless(gameConfig, scriptModule, argc - first, argv + first);
+}
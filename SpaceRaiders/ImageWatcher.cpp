@@ -0,0 +1,214 @@
+#include "ImageWatcher.h"
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+const char colorsSuffix[] = ".colors.txt";
+const char glyphsSuffix[] = ".txt";
+
+#if defined(_WIN32)
+// Polling period of the file times
+constexpr int pollPeriodMs = 250;
+
+uint64 GetLastWriteTime(const char* path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+	{
+		return ((uint64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	}
+	return 0;
+}
+#else
+// Timeout of the wait for file events, to check the quit flag
+constexpr int pollTimeoutMs = 200;
+#endif
+
+
+bool EndsWith(const char* str, const char* suffix)
+{
+	const size_t len = strlen(str);
+	const size_t suffixLen = strlen(suffix);
+	return len >= suffixLen && !strcmp(str + len - suffixLen, suffix);
+}
+
+}
+
+
+ImageWatcher::ImageWatcher() :
+	quit { false },
+	notifyFd { -1 }
+{}
+
+
+ImageWatcher::~ImageWatcher()
+{
+	Stop();
+}
+
+
+bool ImageWatcher::Start(const char* directory_)
+{
+	Stop();
+	directory = directory_;
+#if !defined(_WIN32)
+	notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (notifyFd < 0)
+	{
+		return false;
+	}
+	// Editors either rewrite the file or write a new one and rename it
+	if (inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+	{
+		close(notifyFd);
+		notifyFd = -1;
+		return false;
+	}
+#endif
+	quit = false;
+	thread = std::thread(&ImageWatcher::WatchLoop, this);
+	return true;
+}
+
+
+void ImageWatcher::Stop()
+{
+	if (thread.joinable())
+	{
+		quit = true;
+		thread.join();
+	}
+#if !defined(_WIN32)
+	if (notifyFd >= 0)
+	{
+		close(notifyFd);
+		notifyFd = -1;
+	}
+#endif
+}
+
+
+int ImageWatcher::ApplyChanges(std::vector<ImageId>& changed)
+{
+	int numChanged = 0;
+	std::lock_guard<std::mutex> lock(mutex);
+	for (int i = 1; i < (int)numImages; ++i)
+	{
+		Slot& slot = slots[i];
+		if (slot.pending)
+		{
+			// The previous glyphs are released here, nothing refers to them between frames
+			slot.active = std::move(slot.pending);
+			const TextImage& src = *slot.active;
+			slot.image = { src.img.data(), src.colors.empty() ? nullptr : src.colors.data(), src.width, src.height };
+			ReplaceImage((ImageId)i, slot.image);
+			changed.push_back((ImageId)i);
+			++numChanged;
+		}
+	}
+	return numChanged;
+}
+
+
+void ImageWatcher::WatchLoop()
+{
+#if defined(_WIN32)
+	// Same approach as the script DLL: compare the last write times
+	uint64 writeTimes[numImages][2] = {};
+	std::string path;
+	for (bool first = true; !quit; first = false)
+	{
+		for (int i = 1; i < (int)numImages; ++i)
+		{
+			bool modified = false;
+			for (int f = 0; f < 2; ++f)
+			{
+				path = directory + '/' + GetImageName((ImageId)i) + (f ? colorsSuffix : glyphsSuffix);
+				const uint64 t = GetLastWriteTime(path.c_str());
+				modified |= (t != writeTimes[i][f]);
+				writeTimes[i][f] = t;
+			}
+			if (modified && !first)
+			{
+				ReloadImage(i);
+			}
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(pollPeriodMs));
+	}
+#else
+	alignas(inotify_event) char buffer[4096];
+	while (!quit)
+	{
+		pollfd pfd = { notifyFd, POLLIN, 0 };
+		if (poll(&pfd, 1, pollTimeoutMs) <= 0)
+		{
+			continue;
+		}
+		const ssize_t size = read(notifyFd, buffer, sizeof(buffer));
+		for (ssize_t offset = 0; offset < size; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+			const int index = event->len ? FindImageIndex(event->name) : -1;
+			if (index > 0)
+			{
+				ReloadImage(index);
+			}
+		}
+	}
+#endif
+}
+
+
+void ImageWatcher::ReloadImage(int index)
+{
+	const std::string base = directory + '/' + GetImageName((ImageId)index);
+	const std::string glyphs = base + glyphsSuffix;
+	const std::string colors = base + colorsSuffix;
+	FILE* colorFile = fopen(colors.c_str(), "rb");
+	if (colorFile)
+	{
+		fclose(colorFile);
+	}
+	std::unique_ptr<TextImage> image { new TextImage };
+	if (!LoadTextImage(*image, glyphs.c_str(), colorFile ? colors.c_str() : nullptr))
+	{
+		return; // keep the current image, e.g. the file is being written
+	}
+	std::lock_guard<std::mutex> lock(mutex);
+	slots[index].pending = std::move(image);
+}
+
+
+int ImageWatcher::FindImageIndex(const char* fileName) const
+{
+	if (!EndsWith(fileName, glyphsSuffix))
+	{
+		return -1;
+	}
+	// name.txt or name.colors.txt
+	const size_t len = strlen(fileName) - (EndsWith(fileName, colorsSuffix) ? strlen(colorsSuffix) : strlen(glyphsSuffix));
+	for (int i = 1; i < (int)numImages; ++i)
+	{
+		const char* name = GetImageName((ImageId)i);
+		if (strlen(name) == len && !strncmp(name, fileName, len))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Images.h"
+#include "AssetPack.h"
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <string>
+
+
+// Hot reloading of images. Watches a directory of text images named after the images (planet.txt, with
+// optional colors in planet.colors.txt). Changed files are parsed by a background thread, the new
+// images are installed by ApplyChanges at a frame boundary so that the game loop never waits on the disk
+class ImageWatcher
+{
+public:
+
+	ImageWatcher();
+	~ImageWatcher();
+
+	bool Start(const char* directory);
+	void Stop();
+
+	// Installs the images reloaded since the last call and appends their ids to changed. Returns the
+	// number of images installed
+	int ApplyChanges(std::vector<ImageId>& changed);
+
+private:
+
+	void WatchLoop();
+	void ReloadImage(int index);
+	int FindImageIndex(const char* fileName) const;
+
+	struct Slot
+	{
+		std::unique_ptr<TextImage> pending; // parsed, waiting for ApplyChanges
+		std::unique_ptr<TextImage> active;  // owns the glyphs of image
+		Image                      image;
+	};
+
+	std::string       directory;
+	Slot              slots[numImages];
+	std::mutex        mutex; // guards the pending images
+	std::thread       thread;
+	std::atomic<bool> quit;
+	int               notifyFd; // inotify instance on Linux
+};
@@ -2,7 +2,9 @@
 #include "Images.h"
 #include "Vector2D.h"
 #include "Colors.h"
+#include "AssetPack.h"
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <sys/stat.h>
 
@@ -416,12 +418,113 @@ const Image images[numImages] =
 	{ _3Img, nullptr, 8, 5 },
 };
 
+
+// Names of the images in asset packs
+const char* const imageNames[numImages] =
+{
+	"null",
+	"planet",
+	"alien0_0",
+	"alien0_1",
+	"alien1_0",
+	"alien1_1",
+	"alien2_0",
+	"alien2_1",
+	"alien3_0",
+	"alien3_1",
+	"boss0_0",
+	"boss0_1",
+	"boss1_0",
+	"boss1_1",
+	"boss2_0",
+	"boss2_1",
+	"playerLaser",
+	"playerLaserLeft",
+	"playerLaserRight",
+	"alienLaser",
+	"player",
+	"explosion",
+	"dPowerUp",
+	"tPowerUp",
+	"sPowerUp",
+	"fPowerUp",
+	"iPowerUp",
+	"shPowerUp",
+	"shield",
+	"solidWall",
+	"brittleWall",
+	"bomb",
+	"snowFlake",
+	"gift",
+	"happyHolidays",
+	"xmasLeaf",
+	"level",
+	"girl",
+	"_0",
+	"_1",
+	"_2",
+	"_3",
+};
+
+// Built-in images, replaced by the images of the asset pack if one is loaded
+const Image* activeImages[numImages];
+uint imageVersions[numImages];
+AssetPack assetPack;
+
 }
 
 
 const Image& GetImage(ImageId imageId)
 {
-	return images[(int)imageId];
+	const Image* image = activeImages[(int)imageId];
+	return image ? *image : images[(int)imageId];
+}
+
+
+const char* GetImageName(ImageId imageId)
+{
+	return imageNames[(int)imageId];
+}
+
+
+bool LoadAssetPack(const char* fileName)
+{
+	if (!assetPack.Open(fileName))
+	{
+		return false;
+	}
+	for (size_t i = 1; i < numImages; ++i)
+	{
+		activeImages[i] = assetPack.FindImage(imageNames[i]);
+	}
+	return true;
+}
+
+
+void ReplaceImage(ImageId imageId, const Image& image)
+{
+	activeImages[(int)imageId] = &image;
+	++imageVersions[(int)imageId];
+}
+
+
+uint GetImageVersion(ImageId imageId)
+{
+	return imageVersions[(int)imageId];
+}
+
+
+const Image* FindImage(const char* name)
+{
+	const Image* image = assetPack.IsOpen() ? assetPack.FindImage(name) : nullptr;
+	for (size_t i = 0; i < numImages && !image; ++i)
+	{
+		if (!strcmp(imageNames[i], name))
+		{
+			image = &GetImage((ImageId)i);
+		}
+	}
+	return image;
 }
 
 
@@ -51,6 +51,17 @@ enum class ImageId
 constexpr size_t numImages = static_cast<size_t>(ImageId::_3) + 1;
 
 const Image& GetImage(ImageId imageId);
+const char* GetImageName(ImageId imageId);
+
+// Maps an asset pack, its images replace the built-in images with the same name. Images are used in
+// place, the pack stays mapped until exit
+bool LoadAssetPack(const char* fileName);
+// Image by name, from the asset pack or built-in. Null if not found
+const Image* FindImage(const char* name);
+// Used by hot reloading, at a frame boundary. The image must stay valid until it is replaced again
+void ReplaceImage(ImageId imageId, const Image& image);
+// Incremented every time the image is replaced, caches of data derived from an image compare versions
+uint GetImageVersion(ImageId imageId);
 
 struct Vector2D;
 Vector2D GetImageSize(ImageId imageId);
\ No newline at end of file
@@ -1,5 +1,11 @@
 #include "Input.h"
+#include <cstring>
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <chrono>
+#include <thread>
+#endif
 
 
 namespace
@@ -8,6 +14,7 @@ namespace
 
 int prevKeyState[numKeyCodes] = { -1 };
 int keyState[numKeyCodes] = { -1 };
+#if defined(_WIN32)
 const int keyCodeToVKey[numKeyCodes] =
 {
 	VK_ESCAPE,
@@ -23,8 +30,12 @@ const int keyCodeToVKey[numKeyCodes] =
 	'4',
 	'5',
 	'A',
-	'D'
+	'D',
+	VK_PRIOR,
+	VK_NEXT,
+	VK_HOME
 };
+#endif
 
 }
 
@@ -34,7 +45,11 @@ void UpdateKeyStates()
 	std::memcpy(prevKeyState, keyState, sizeof(prevKeyState));
 	for (size_t i = 0; i < numKeyCodes; ++i)
 	{
+#if defined(_WIN32)
 		keyState[i] = (GetAsyncKeyState(keyCodeToVKey[i]) & 0x8000) ? 1 : 0;
+#else
+		keyState[i] = 0; // no keyboard, e.g. headless runs
+#endif
 	}
 }
 
@@ -70,6 +85,33 @@ bool AnyKeyJustPressed()
 }
 
 
+bool PollKey(KeyCode keyCode)
+{
+#if defined(_WIN32)
+	return (GetAsyncKeyState(keyCodeToVKey[(int)keyCode]) & 0x8000) != 0;
+#else
+	(void)keyCode;
+	return false;
+#endif
+}
+
+
+bool WaitForInput(float timeout)
+{
+#if defined(_WIN32)
+	const HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+	// Keys are read with GetAsyncKeyState, nothing reads the console input: without the flush the events
+	// of the previous frames would end the wait at once
+	FlushConsoleInputBuffer(input);
+	return WaitForSingleObject(input, (DWORD)(timeout * 1000.f)) == WAIT_OBJECT_0;
+#else
+	// No keyboard
+	std::this_thread::sleep_for(std::chrono::duration<float>(timeout));
+	return false;
+#endif
+}
+
+
 RndInput::RndInput(std::default_random_engine& rGen) : 
 	rGen {rGen}, 
 	accumTime {0},
@@ -18,9 +18,12 @@ enum class KeyCode
 	_4,
 	_5,
 	A,
-	D
+	D,
+	pageUp,
+	pageDown,
+	home
 };
-constexpr size_t numKeyCodes = static_cast<size_t>(KeyCode::D) + 1;
+constexpr size_t numKeyCodes = static_cast<size_t>(KeyCode::home) + 1;
 
 
 void UpdateKeyStates();
@@ -28,6 +31,10 @@ bool KeyPressed(KeyCode keyCode);
 bool KeyJustPressed(KeyCode keyCode);
 bool KeyJustReleased(KeyCode keyCode);
 bool AnyKeyJustPressed();
+// Current state of the key, independent of UpdateKeyStates, for controls outside the simulation steps
+bool PollKey(KeyCode keyCode);
+// Blocks until a console input event or the timeout [s]. True on input
+bool WaitForInput(float timeout);
 
 
 class Input
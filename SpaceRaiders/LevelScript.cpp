@@ -0,0 +1,302 @@
+#include "LevelScript.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <exception>
+#include <new>
+
+
+namespace
+{
+
+// In front of every frame: the runner whose arena holds it, nullptr for the heap
+struct alignas(std::max_align_t) FrameHeader
+{
+	LevelScriptRunner* owner;
+};
+
+constexpr size_t frameAlignment = alignof(std::max_align_t);
+
+}
+
+
+LevelScriptRunner* LevelScriptRunner::starting = nullptr;
+
+
+void* LevelScript::promise_type::operator new(size_t size)
+{
+	LevelScriptRunner* owner = LevelScriptRunner::starting;
+	void* mem = owner ? owner->Allocate(sizeof(FrameHeader) + size) : nullptr;
+	if (! mem)
+	{
+		// Started outside a runner, or the arena is full
+		owner = nullptr;
+		mem = ::operator new(sizeof(FrameHeader) + size);
+	}
+	FrameHeader* const header = (FrameHeader*)mem;
+	header->owner = owner;
+	return header + 1;
+}
+
+
+void LevelScript::promise_type::operator delete(void* ptr)
+{
+	FrameHeader* const header = (FrameHeader*)ptr - 1;
+	if (! header->owner)
+	{
+		::operator delete(header);
+	}
+	// Arena frames are released all at once when the runner stops
+}
+
+
+LevelScript LevelScript::promise_type::get_return_object()
+{
+	return LevelScript(Handle::from_promise(*this));
+}
+
+
+void LevelScript::promise_type::unhandled_exception()
+{
+	std::terminate();
+}
+
+
+LevelScript::LevelScript(Handle handle_) : handle(handle_)
+{
+}
+
+
+LevelScript::LevelScript(LevelScript&& other) noexcept : handle(other.handle)
+{
+	other.handle = nullptr;
+}
+
+
+LevelScript& LevelScript::operator=(LevelScript&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (handle)
+		{
+			handle.destroy();
+		}
+		handle = other.handle;
+		other.handle = nullptr;
+	}
+	return *this;
+}
+
+
+LevelScript::~LevelScript()
+{
+	if (handle)
+	{
+		handle.destroy();
+	}
+}
+
+
+LevelScript::Handle LevelScript::GetHandle() const
+{
+	return handle;
+}
+
+
+bool TimeAwaiter::await_suspend(LevelScript::Handle handle) const
+{
+	LevelScript::promise_type& p = handle.promise();
+	const float at = relative ? p.time + time : std::max(time, p.time);
+	if (at <= p.time)
+	{
+		return false;
+	}
+	p.wait = LevelScript::Wait::time;
+	p.wakeTime = at;
+	return true;
+}
+
+
+void ConditionAwaiter::await_suspend(LevelScript::Handle handle) const
+{
+	assert(condition);
+	LevelScript::promise_type& p = handle.promise();
+	p.wait = LevelScript::Wait::condition;
+	p.condition = condition;
+}
+
+
+void SignalAwaiter::await_suspend(LevelScript::Handle handle) const
+{
+	assert(signal < LevelSignal::count);
+	LevelScript::promise_type& p = handle.promise();
+	p.wait = LevelScript::Wait::signal;
+	p.signal = signal;
+	p.signalled = false;
+}
+
+
+TimeAwaiter At(float levelTime)
+{
+	return { levelTime, false };
+}
+
+
+TimeAwaiter Wait(float seconds)
+{
+	assert(seconds >= 0.f);
+	return { seconds, true };
+}
+
+
+ConditionAwaiter Until(EventCondition condition)
+{
+	return { condition };
+}
+
+
+SignalAwaiter WaitFor(LevelSignal signal)
+{
+	return { signal };
+}
+
+
+LevelScriptRunner::LevelScriptRunner() : arena(arenaSize), arenaUsed(0), time(0.f)
+{
+	scripts.reserve(maxScripts);
+}
+
+
+LevelScriptRunner::~LevelScriptRunner()
+{
+	Stop();
+}
+
+
+bool LevelScriptRunner::Run(LevelScriptFunc script, Game& game)
+{
+	assert(script);
+	if ((int)scripts.size() >= maxScripts)
+	{
+		return false;
+	}
+	starting = this;
+	scripts.push_back(script(game));
+	starting = nullptr;
+	LevelScript::promise_type& p = scripts.back().GetHandle().promise();
+	p.time = time;
+	p.wait = LevelScript::Wait::time;
+	p.wakeTime = time;
+	return true;
+}
+
+
+void LevelScriptRunner::Stop()
+{
+	scripts.clear();
+	arenaUsed = 0;
+	time = 0.f;
+}
+
+
+void LevelScriptRunner::Update(float dt, Game& game)
+{
+	time += dt;
+	// Resumes the earliest script due until none is. Conditions and signals count from the time the
+	// script started waiting, a script due several times in the step runs several times
+	for (;;)
+	{
+		LevelScript::Handle next = nullptr;
+		float nextTime = 0.f;
+		for (const LevelScript& script : scripts)
+		{
+			const LevelScript::Handle handle = script.GetHandle();
+			if (handle.done())
+			{
+				continue;
+			}
+			const LevelScript::promise_type& p = handle.promise();
+			bool due = false;
+			float at = p.time;
+			switch (p.wait)
+			{
+			case LevelScript::Wait::time:
+				due = p.wakeTime < time;
+				at = p.wakeTime;
+				break;
+			case LevelScript::Wait::condition:
+				due = p.condition(game);
+				break;
+			case LevelScript::Wait::signal:
+				due = p.signalled;
+				break;
+			default:
+				break;
+			}
+			if (due && (! next || at < nextTime))
+			{
+				next = handle;
+				nextTime = at;
+			}
+		}
+		if (! next)
+		{
+			break;
+		}
+		Resume(next, next.promise().wait == LevelScript::Wait::time ? nextTime : time);
+	}
+}
+
+
+void LevelScriptRunner::Raise(LevelSignal signal)
+{
+	for (const LevelScript& script : scripts)
+	{
+		const LevelScript::Handle handle = script.GetHandle();
+		LevelScript::promise_type& p = handle.promise();
+		if (! handle.done() && p.wait == LevelScript::Wait::signal && p.signal == signal)
+		{
+			p.signalled = true;
+		}
+	}
+}
+
+
+bool LevelScriptRunner::IsDone() const
+{
+	return std::all_of(scripts.begin(), scripts.end(), [](const LevelScript& script) { return script.GetHandle().done(); });
+}
+
+
+float LevelScriptRunner::GetTime() const
+{
+	return time;
+}
+
+
+size_t LevelScriptRunner::GetArenaUsed() const
+{
+	return arenaUsed;
+}
+
+
+void* LevelScriptRunner::Allocate(size_t size)
+{
+	size = (size + frameAlignment - 1) & ~(frameAlignment - 1);
+	if (arenaUsed + size > arena.size())
+	{
+		return nullptr;
+	}
+	void* const mem = arena.data() + arenaUsed;
+	arenaUsed += size;
+	return mem;
+}
+
+
+void LevelScriptRunner::Resume(LevelScript::Handle handle, float wakeTime)
+{
+	LevelScript::promise_type& p = handle.promise();
+	p.wait = LevelScript::Wait::none;
+	p.time = wakeTime;
+	handle.resume();
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Base.h"
+#include "Event.h"
+#include <vector>
+
+// C++20 coroutines, or the Coroutines TS of older compilers
+#if defined(__cpp_impl_coroutine) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <coroutine>
+namespace coro = std;
+#else
+#include <experimental/coroutine>
+namespace coro = std::experimental;
+#endif
+
+
+class LevelScriptRunner;
+
+
+// World events level scripts can wait for
+enum class LevelSignal
+{
+	alienDestroyed,
+	playerDestroyed,
+	powerUpTaken,
+	count
+};
+
+
+// Level script coroutine, started suspended and resumed by a LevelScriptRunner:
+//
+//	LevelScript Level0(Game& game)
+//	{
+//		co_await At(2.f);
+//		SpawnAlienWave(alienWaves[0], game.world, game.config);
+//		co_await Until(NoAliensLeft);
+//		SpawnBoss(bossInfo[0], game.world, game.config);
+//	}
+//
+// The frame is allocated from the arena of the runner, resuming allocates nothing
+class LevelScript
+{
+public:
+
+	enum class Wait
+	{
+		none,
+		time,
+		condition,
+		signal
+	};
+
+	struct promise_type
+	{
+		float          time = 0.f; // level time of the last wake up, waits count from it
+		Wait           wait = Wait::none;
+		float          wakeTime = 0.f;
+		EventCondition condition = nullptr;
+		LevelSignal    signal = LevelSignal::count;
+		bool           signalled = false;
+
+		static void* operator new(size_t size);
+		static void operator delete(void* ptr);
+		LevelScript get_return_object();
+		coro::suspend_always initial_suspend() noexcept { return {}; }
+		coro::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception();
+	};
+	typedef coro::coroutine_handle<promise_type> Handle;
+
+	LevelScript() = default;
+	explicit LevelScript(Handle handle);
+	LevelScript(LevelScript&& other) noexcept;
+	LevelScript& operator=(LevelScript&& other) noexcept;
+	~LevelScript();
+	LevelScript(const LevelScript&) = delete;
+	LevelScript& operator=(const LevelScript&) = delete;
+
+	Handle GetHandle() const;
+
+private:
+
+	Handle handle;
+};
+
+typedef LevelScript (*LevelScriptFunc)(Game& game);
+
+
+// Awaitables
+struct TimeAwaiter
+{
+	float time;
+	bool  relative;
+
+	bool await_ready() const { return false; }
+	bool await_suspend(LevelScript::Handle handle) const;
+	void await_resume() const {}
+};
+
+struct ConditionAwaiter
+{
+	EventCondition condition;
+
+	bool await_ready() const { return false; }
+	void await_suspend(LevelScript::Handle handle) const;
+	void await_resume() const {}
+};
+
+struct SignalAwaiter
+{
+	LevelSignal signal;
+
+	bool await_ready() const { return false; }
+	void await_suspend(LevelScript::Handle handle) const;
+	void await_resume() const {}
+};
+
+// Level time. Like the event tables a script never goes back in time, a time already passed
+// continues at once
+TimeAwaiter At(float levelTime);
+// Delay from the last wake up, not from the end of the step, so waits do not drift
+TimeAwaiter Wait(float seconds);
+// Checked from the current step, then every step until true
+ConditionAwaiter Until(EventCondition condition);
+// Next time the world raises the signal
+SignalAwaiter WaitFor(LevelSignal signal);
+
+
+// Scheduler of the scripts of a level. Update resumes, in time order, every script due in the step,
+// as many times as due. Coroutine frames come from an arena reset when the level stops
+class LevelScriptRunner
+{
+public:
+
+	static constexpr size_t arenaSize = 16 * 1024;
+	static constexpr int maxScripts = 8;
+
+	LevelScriptRunner();
+	~LevelScriptRunner();
+	LevelScriptRunner(const LevelScriptRunner&) = delete;
+	LevelScriptRunner& operator=(const LevelScriptRunner&) = delete;
+
+	// Starts script(game) at the current level time. It runs from the next update
+	bool Run(LevelScriptFunc script, Game& game);
+	// Destroys all the scripts, resets the arena and the level time
+	void Stop();
+	// Advances the level time by dt and resumes the scripts due
+	void Update(float dt, Game& game);
+	// Wakes up the scripts waiting for the signal at the next update
+	void Raise(LevelSignal signal);
+
+	bool IsDone() const;
+	float GetTime() const;
+	size_t GetArenaUsed() const;
+
+private:
+
+	friend struct LevelScript::promise_type;
+
+	void* Allocate(size_t size);
+	void Resume(LevelScript::Handle handle, float wakeTime);
+
+	// Runner starting a script, for promise_type::operator new
+	static LevelScriptRunner* starting;
+
+	std::vector<byte>        arena;
+	size_t                   arenaUsed;
+	std::vector<LevelScript> scripts;
+	float                    time;
+};
@@ -0,0 +1,127 @@
+#include "MappedFile.h"
+#include <cassert>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile() :
+	data { nullptr },
+	size { 0 },
+	handle { nullptr }
+{}
+
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char* fileName)
+{
+	assert(!data);
+	HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+	// The mapping keeps the file open
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+	{
+		return false;
+	}
+	data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	handle = mapping;
+	size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (data)
+	{
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)handle);
+	}
+	data = nullptr;
+	handle = nullptr;
+	size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char* fileName)
+{
+	assert(!data);
+	const int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	void* p = (fstat(fd, &st) == 0 && st.st_size > 0) ? mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (p == MAP_FAILED)
+	{
+		return false;
+	}
+	data = p;
+	size = (size_t)st.st_size;
+	return true;
+}
+
+
+void MappedFile::Close()
+{
+	if (data)
+	{
+		munmap(const_cast<void*>(data), size);
+	}
+	data = nullptr;
+	size = 0;
+}
+
+#endif
+
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
+
+
+const void* MappedFile::GetData() const
+{
+	return data;
+}
+
+
+size_t MappedFile::GetSize() const
+{
+	return size;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+
+// Read only view of a whole file mapped in memory
+class MappedFile
+{
+public:
+
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* fileName);
+	void Close();
+	bool IsOpen() const;
+
+	const void* GetData() const;
+	size_t      GetSize() const;
+
+private:
+
+	const void* data;
+	size_t      size;
+	void*       handle; // file mapping handle on Windows
+};
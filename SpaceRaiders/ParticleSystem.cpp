@@ -0,0 +1,225 @@
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define PARTICLES_SSE2 1
+#include <emmintrin.h>
+#else
+#define PARTICLES_SSE2 0
+#endif
+
+
+ParticleEmitter NewParticleEmitter(const Vector2D& pos, float life, const Visual& visual)
+{
+	ParticleEmitter e;
+	e.pos = pos;
+	e.area = { 0.f, 0.f };
+	e.velocity = { 0.f, 0.f };
+	e.velocitySpread = { 0.f, 0.f };
+	e.life = life;
+	e.delay = 0.f;
+	e.delayStep = 0.f;
+	e.swayPeriod = 0.f;
+	e.rate = 0.f;
+	e.accum = 0.f;
+	e.visual = visual;
+	return e;
+}
+
+
+ParticleSystem::ParticleSystem(RenderLayer layer) :
+	count { 0 },
+	lastDt { 0.f },
+	layer { layer }
+{}
+
+
+void ParticleSystem::Reserve(int capacity)
+{
+	posX.reserve(capacity);
+	posY.reserve(capacity);
+	velX.reserve(capacity);
+	velY.reserve(capacity);
+	delay.reserve(capacity);
+	life.reserve(capacity);
+	swayTime.reserve(capacity);
+	swayPeriod.reserve(capacity);
+	visuals.reserve(capacity);
+}
+
+
+void ParticleSystem::Clear()
+{
+	Resize(0);
+}
+
+
+int ParticleSystem::GetCount() const
+{
+	return count;
+}
+
+
+void ParticleSystem::Emit(const ParticleEmitter& emitter, int numParticles, std::default_random_engine& rGen)
+{
+	assert(numParticles >= 0);
+	std::uniform_real_distribution<float> rnd { 0.f, 1.f };
+	const int first = count;
+	Resize(count + numParticles);
+	for (int i = first; i < count; ++i)
+	{
+		// Same draw order as the spawn loops this replaces: x, then y
+		const float x = emitter.area.x > 0.f ? emitter.area.x * rnd(rGen) : 0.f;
+		const float y = emitter.area.y > 0.f ? emitter.area.y * rnd(rGen) : 0.f;
+		const float vx = emitter.velocitySpread.x > 0.f ? emitter.velocitySpread.x * (2.f * rnd(rGen) - 1.f) : 0.f;
+		const float vy = emitter.velocitySpread.y > 0.f ? emitter.velocitySpread.y * (2.f * rnd(rGen) - 1.f) : 0.f;
+		posX[i] = emitter.pos.x + x;
+		posY[i] = emitter.pos.y + y;
+		velX[i] = emitter.velocity.x + vx;
+		velY[i] = emitter.velocity.y + vy;
+		delay[i] = emitter.delay + (float)(i - first) * emitter.delayStep;
+		life[i] = emitter.life;
+		swayTime[i] = 0.f;
+		swayPeriod[i] = emitter.swayPeriod > 0.f ? emitter.swayPeriod : FLT_MAX;
+		visuals[i] = emitter.visual;
+	}
+}
+
+
+void ParticleSystem::UpdateEmitter(ParticleEmitter& emitter, float dt, std::default_random_engine& rGen)
+{
+	emitter.accum += emitter.rate * dt;
+	const int numParticles = (int)emitter.accum;
+	if (numParticles > 0)
+	{
+		emitter.accum -= (float)numParticles;
+		Emit(emitter, numParticles, rGen);
+	}
+}
+
+
+void ParticleSystem::Update(float dt)
+{
+	lastDt = dt;
+	int i = 0;
+	bool anyDead = false;
+#if PARTICLES_SSE2
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	for (; i + 4 <= count; i += 4)
+	{
+		// A particle is active once its delay is over, only then it moves and ages
+		__m128 d = _mm_loadu_ps(&delay[i]);
+		const __m128 active = _mm_cmple_ps(d, vdt);
+		d = _mm_max_ps(_mm_sub_ps(d, vdt), zero);
+		_mm_storeu_ps(&delay[i], d);
+		const __m128 adt = _mm_and_ps(active, vdt);
+
+		__m128 vx = _mm_loadu_ps(&velX[i]);
+		const __m128 vy = _mm_loadu_ps(&velY[i]);
+		_mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, adt)));
+		_mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, adt)));
+
+		const __m128 l = _mm_sub_ps(_mm_loadu_ps(&life[i]), adt);
+		_mm_storeu_ps(&life[i], l);
+		anyDead |= _mm_movemask_ps(_mm_cmple_ps(l, zero)) != 0;
+
+		// Sway: flip the sign of the horizontal velocity and restart the period
+		__m128 t = _mm_add_ps(_mm_loadu_ps(&swayTime[i]), adt);
+		const __m128 flip = _mm_cmpgt_ps(t, _mm_loadu_ps(&swayPeriod[i]));
+		vx = _mm_xor_ps(vx, _mm_and_ps(flip, signBit));
+		t = _mm_andnot_ps(flip, t);
+		_mm_storeu_ps(&velX[i], vx);
+		_mm_storeu_ps(&swayTime[i], t);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		const bool active = delay[i] <= dt;
+		const float adt = active ? dt : 0.f;
+		delay[i] = std::max(delay[i] - dt, 0.f);
+		posX[i] += velX[i] * adt;
+		posY[i] += velY[i] * adt;
+		life[i] -= adt;
+		anyDead |= life[i] <= 0.f;
+		swayTime[i] += adt;
+		if (swayTime[i] > swayPeriod[i])
+		{
+			velX[i] = -velX[i];
+			swayTime[i] = 0.f;
+		}
+	}
+	if (anyDead)
+	{
+		RemoveDead();
+	}
+}
+
+
+void ParticleSystem::GetRenderItems(std::vector<RenderItem>& ritems) const
+{
+	int numVisible = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		numVisible += delay[i] <= 0.f;
+	}
+	size_t out = ritems.size();
+	ritems.resize(out + numVisible);
+	for (int i = 0; i < count; ++i)
+	{
+		if (delay[i] <= 0.f)
+		{
+			RenderItem& item = ritems[out++];
+			item.pos = { posX[i], posY[i] };
+			item.prevPos = { posX[i] - velX[i] * lastDt, posY[i] - velY[i] * lastDt };
+			item.visual = visuals[i];
+			item.layer = layer;
+		}
+	}
+}
+
+
+void ParticleSystem::Resize(int newCount)
+{
+	posX.resize(newCount);
+	posY.resize(newCount);
+	velX.resize(newCount);
+	velY.resize(newCount);
+	delay.resize(newCount);
+	life.resize(newCount);
+	swayTime.resize(newCount);
+	swayPeriod.resize(newCount);
+	visuals.resize(newCount);
+	count = newCount;
+}
+
+
+void ParticleSystem::RemoveDead()
+{
+	// Compact in place, keeping the spawn order so that the draw order does not change
+	int n = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		if (life[i] <= 0.f)
+		{
+			continue;
+		}
+		if (n != i)
+		{
+			posX[n] = posX[i];
+			posY[n] = posY[i];
+			velX[n] = velX[i];
+			velY[n] = velY[i];
+			delay[n] = delay[i];
+			life[n] = life[i];
+			swayTime[n] = swayTime[i];
+			swayPeriod[n] = swayPeriod[i];
+			visuals[n] = visuals[i];
+		}
+		++n;
+	}
+	Resize(n);
+}
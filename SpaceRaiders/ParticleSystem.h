@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Vector2D.h"
+#include "RenderItem.h"
+#include <vector>
+#include <random>
+
+
+// Describes the particles spawned by an emitter
+struct ParticleEmitter
+{
+	Vector2D pos;
+	Vector2D area;           // particles spawn at a random position in [pos, pos + area]
+	Vector2D velocity;
+	Vector2D velocitySpread; // a random amount in [-velocitySpread, velocitySpread] is added to the velocity
+	float    life;           // [s]
+	float    delay;          // hidden for delay seconds before the life starts
+	float    delayStep;      // the i-th particle of a burst gets i * delayStep more delay
+	float    swayPeriod;     // the horizontal velocity flips every swayPeriod seconds, 0: no sway
+	float    rate;           // particles per second spawned by UpdateEmitter
+	float    accum;          // particles due but not spawned yet
+	Visual   visual;
+};
+
+
+ParticleEmitter NewParticleEmitter(const Vector2D& pos, float life, const Visual& visual);
+
+
+// Particles stored as a structure of arrays, so that integration and lifetime updates run four
+// particles at a time
+class ParticleSystem
+{
+public:
+
+	explicit ParticleSystem(RenderLayer layer);
+
+	void Reserve(int capacity);
+	void Clear();
+	int GetCount() const;
+
+	// Spawns count particles at once. Random numbers are drawn only for the non zero spreads
+	void Emit(const ParticleEmitter& emitter, int count, std::default_random_engine& rGen);
+	// Spawns the particles due at the emitter rate over dt
+	void UpdateEmitter(ParticleEmitter& emitter, float dt, std::default_random_engine& rGen);
+	// Moves the particles, advances delays and lifetimes and deletes the expired particles
+	void Update(float dt);
+	// Appends one render item per visible particle
+	void GetRenderItems(std::vector<RenderItem>& ritems) const;
+
+private:
+
+	void Resize(int newCount);
+	void RemoveDead();
+
+	std::vector<float>  posX;
+	std::vector<float>  posY;
+	std::vector<float>  velX;
+	std::vector<float>  velY;
+	std::vector<float>  delay;
+	std::vector<float>  life;
+	std::vector<float>  swayTime;
+	std::vector<float>  swayPeriod;
+	std::vector<Visual> visuals;
+	int                 count;
+	float               lastDt; // to compute the previous positions for interpolation
+	RenderLayer         layer;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+struct CharInfo;
+
+
+// A presenter receives every finished canvas from the renderer, e.g. to write it to a console,
+// keep it in memory or record it to a file
+class Presenter
+{
+public:
+
+	virtual ~Presenter() = default;
+	// canvas: cols * rows cells, row major
+	virtual void Present(const CharInfo* canvas, int cols, int rows) = 0;
+};
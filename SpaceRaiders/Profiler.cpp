@@ -0,0 +1,162 @@
+#include "Profiler.h"
+
+#if PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace
+{
+
+constexpr uint64 ringSize = 1 << 16; // zones kept per thread, the oldest are overwritten
+
+struct ProfileEvent
+{
+	const char* name;
+	uint64      begin;
+	uint64      end;
+};
+
+// Written by its thread only. The exporter reads the head with acquire semantics and drops the events
+// the thread may have overwritten while they were copied
+struct ThreadBuffer
+{
+	ProfileEvent        events[ringSize];
+	std::atomic<uint64> head { 0 };
+	int                 tid = 0;
+	char                name[32] = {};
+};
+
+std::mutex buffersMutex;
+// Never freed, the zones of finished threads can still be exported
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+typedef std::chrono::steady_clock Clock;
+// Start of the trace, to convert profile times to microseconds
+const uint64 startTime = GetProfileTime();
+const Clock::time_point startClock = Clock::now();
+
+
+ThreadBuffer& GetThreadBuffer()
+{
+	if (!threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffers.emplace_back(new ThreadBuffer);
+		threadBuffer = buffers.back().get();
+		threadBuffer->tid = (int)buffers.size();
+	}
+	return *threadBuffer;
+}
+
+
+void WriteString(FILE* file, const char* str)
+{
+	fputc('"', file);
+	for (; *str; ++str)
+	{
+		if (*str == '"' || *str == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+}
+
+
+void RecordProfileZone(const char* name, uint64 begin, uint64 end)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	const uint64 head = buffer.head.load(std::memory_order_relaxed);
+	buffer.events[head & (ringSize - 1)] = { name, begin, end };
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+
+void SetProfileThreadName(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	snprintf(buffer.name, sizeof(buffer.name), "%s", name);
+}
+
+
+bool WriteProfileTrace(const char* fileName)
+{
+	// Ticks per microsecond, measured over the whole run for the time stamp counter
+#if PROFILER_TSC
+	const double elapsedUs = std::chrono::duration<double, std::micro>(Clock::now() - startClock).count();
+	const double ticksPerUs = elapsedUs > 0. ? (double)(GetProfileTime() - startTime) / elapsedUs : 1.;
+#else
+	const double ticksPerUs = 1000.;
+#endif
+
+	std::vector<ThreadBuffer*> threads;
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		for (const auto& buffer : buffers)
+		{
+			threads.push_back(buffer.get());
+		}
+	}
+
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+	{
+		return false;
+	}
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	std::vector<ProfileEvent> events;
+	for (const ThreadBuffer* thread : threads)
+	{
+		fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", thread->tid);
+		if (thread->name[0])
+		{
+			WriteString(file, thread->name);
+		}
+		else
+		{
+			fprintf(file, "\"Thread %d\"", thread->tid);
+		}
+		fprintf(file, "}}");
+		first = false;
+
+		const uint64 head = thread->head.load(std::memory_order_acquire);
+		const uint64 tail = head > ringSize ? head - ringSize : 0;
+		events.clear();
+		for (uint64 i = tail; i < head; ++i)
+		{
+			events.push_back(thread->events[i & (ringSize - 1)]);
+		}
+		// Events written over while copying are garbage
+		const uint64 newHead = thread->head.load(std::memory_order_acquire);
+		const uint64 skip = std::min<uint64>(events.size(), newHead - head);
+		for (size_t i = (size_t)skip; i < events.size(); ++i)
+		{
+			const ProfileEvent& e = events[i];
+			if (e.begin < startTime)
+			{
+				continue;
+			}
+			fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":", thread->tid,
+				(double)(e.begin - startTime) / ticksPerUs, (double)(e.end - e.begin) / ticksPerUs);
+			WriteString(file, e.name);
+			fputc('}', file);
+		}
+	}
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
+
+#endif
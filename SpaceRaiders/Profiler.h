@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Base.h"
+
+// Scoped instrumentation profiler. Zones record their begin and end times into a ring buffer owned by
+// the calling thread, without locks, and are exported as Chrome trace events (chrome://tracing or
+// ui.perfetto.dev). Everything compiles out unless PROFILER is defined to 1
+#ifndef PROFILER
+#define PROFILER 0
+#endif
+
+#if PROFILER
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_TSC 1
+#else
+#include <chrono>
+#define PROFILER_TSC 0
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// Times the rest of the enclosing scope. name must be a string literal
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__) { name }
+// Names the calling thread in the trace
+#define PROFILE_THREAD(name) SetProfileThreadName(name)
+
+
+// Time stamp counter where available, steady clock nanoseconds otherwise. Converted to microseconds
+// on export
+inline uint64 GetProfileTime()
+{
+#if PROFILER_TSC
+	return __rdtsc();
+#else
+	return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void RecordProfileZone(const char* name, uint64 begin, uint64 end);
+void SetProfileThreadName(const char* name);
+// Writes the zones still in the ring buffers of all threads
+bool WriteProfileTrace(const char* fileName);
+
+
+class ProfileZone
+{
+public:
+
+	explicit ProfileZone(const char* name) :
+		name { name },
+		begin { GetProfileTime() }
+	{
+	}
+
+	~ProfileZone()
+	{
+		RecordProfileZone(name, begin, GetProfileTime());
+	}
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+
+	const char* name;
+	uint64      begin;
+};
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+inline bool WriteProfileTrace(const char*)
+{
+	return false;
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "Random.h"
 #include <cassert>
+#include <cstring>
 
 
 Random::Random(int numValues, std::default_random_engine& rGen) :
@@ -16,8 +16,8 @@ private:
 
 	static constexpr int maxValues = 32;
 
-	std::default_random_engine& rGen;
-	std::uniform_int<int>       rndInt;
-	int                         history[maxValues];
-	int                         last;
+	std::default_random_engine&        rGen;
+	std::uniform_int_distribution<int> rndInt;
+	int                                history[maxValues];
+	int                                last;
 };
\ No newline at end of file
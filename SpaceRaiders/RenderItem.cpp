@@ -1,5 +1,6 @@
 #include "RenderItem.h"
 #include "Images.h"
+#include <cassert>
 
 
 void UpdateAnimation(AnimState& state, const Animation& anim, float dt)
@@ -15,3 +16,55 @@ void UpdateAnimation(AnimState& state, const Animation& anim, float dt)
 		}
 	}
 }
+
+
+uint16 GetSortKey(const RenderItem& item)
+{
+	return (uint16)(((uint)item.layer << 8) | ((uint)item.visual.imageId & 0xFF));
+}
+
+
+void SortRenderItems(const RenderItem* items, int count, std::vector<uint32>& order, std::vector<uint32>& temp)
+{
+	assert(count >= 0 && count <= 0x10000);
+	order.resize(count);
+	temp.resize(count);
+	// Entries are key << 16 | index. One pass builds the histograms of both key bytes
+	uint32 histogram[2][256] = {};
+	for (int i = 0; i < count; ++i)
+	{
+		const uint32 key = GetSortKey(items[i]);
+		order[i] = (key << 16) | (uint32)i;
+		++histogram[0][key & 0xFF];
+		++histogram[1][key >> 8];
+	}
+	uint32* src = order.data();
+	uint32* dst = temp.data();
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		const int shift = 16 + pass * 8;
+		uint32* counts = histogram[pass];
+		// Nothing to do if all the keys share this byte
+		if (count == 0 || counts[(src[0] >> shift) & 0xFF] == (uint32)count)
+		{
+			continue;
+		}
+		uint32 sum = 0;
+		for (int b = 0; b < 256; ++b)
+		{
+			const uint32 c = counts[b];
+			counts[b] = sum;
+			sum += c;
+		}
+		for (int i = 0; i < count; ++i)
+		{
+			const uint32 v = src[i];
+			dst[counts[(v >> shift) & 0xFF]++] = v;
+		}
+		std::swap(src, dst);
+	}
+	if (src != order.data())
+	{
+		order.swap(temp);
+	}
+}
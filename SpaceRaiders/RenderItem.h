@@ -1,7 +1,9 @@
 #pragma once
 
+#include "Base.h"
 #include "Vector2D.h"
 #include "Colors.h"
+#include <vector>
 
 
 enum class ImageId;
@@ -26,11 +28,32 @@ struct AnimState
 };
 
 
+// Draw order of the render items, lower layers are drawn first
+enum class RenderLayer : uint8
+{
+	walls,
+	players,
+	shields,
+	aliens,
+	lasers,
+	explosions,
+	powerUps
+};
+
 struct RenderItem
 {
 	Vector2D      pos;
+	Vector2D      prevPos; // position at the previous simulation step, used for interpolation
 	Visual        visual;
+	RenderLayer   layer;
 };
 
 
+// Layer in the high byte, image in the low byte: items of a layer sharing an image are drawn in a row
+uint16 GetSortKey(const RenderItem& item);
+// Stable radix sort of the items by sort key. On return order holds one entry per item in draw
+// order, the item index is in the low 16 bits
+void SortRenderItems(const RenderItem* items, int count, std::vector<uint32>& order, std::vector<uint32>& temp);
+
+
 void UpdateAnimation(AnimState& state, const Animation& anim, float dt);
@@ -3,49 +3,252 @@
 #include "MessageLog.h"
 #include "Image.h"
 #include "Images.h"
-#include "Console.h"
+#include "Presenter.h"
 #include "GameStates.h"
+#include "PlayField.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
 #include <cassert>
+#include <cstring>
+#include <cmath>
 #include <algorithm>
+#include <chrono>
 #include <iostream>
-#define NOMINMAX
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#undef GetMessage
-#undef WriteConsoleOutput
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define HALF_BLOCKS_SSE2 1
+#include <emmintrin.h>
+#else
+#define HALF_BLOCKS_SSE2 0
+#endif
 
 
 namespace
 {
 
+using namespace CharAttribute;
 
-constexpr WORD charColors[(int)Color::count] =
+constexpr uint16 charColors[(int)Color::count] =
 {
-	FOREGROUND_RED,
-	FOREGROUND_RED | FOREGROUND_INTENSITY,
-	FOREGROUND_GREEN,
-	FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-	FOREGROUND_BLUE | FOREGROUND_INTENSITY,
-	FOREGROUND_RED | FOREGROUND_GREEN,
-	FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
+	foregroundRed,
+	foregroundRed | foregroundIntensity,
+	foregroundGreen,
+	foregroundGreen | foregroundIntensity,
+	foregroundBlue | foregroundIntensity,
+	foregroundRed | foregroundGreen,
+	foregroundRed | foregroundGreen | foregroundIntensity,
 	0,
-	FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN,
-	FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-	FOREGROUND_BLUE | FOREGROUND_GREEN,
-	FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_INTENSITY,
-	FOREGROUND_RED | FOREGROUND_BLUE,
-	FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_INTENSITY
+	foregroundRed | foregroundBlue | foregroundGreen,
+	foregroundRed | foregroundBlue | foregroundGreen | foregroundIntensity,
+	foregroundBlue | foregroundGreen,
+	foregroundBlue | foregroundGreen | foregroundIntensity,
+	foregroundRed | foregroundBlue,
+	foregroundRed | foregroundBlue | foregroundIntensity
 };
 
+// Sprites are rasterized in parallel only when there is enough work
+constexpr int minParallelCells = 160 * 100;
+constexpr int minParallelSprites = 256;
+constexpr int minBandHeight = 4;
+
+// Half block glyphs
+constexpr uint16 upperHalf = 0x2580;
+constexpr uint16 lowerHalf = 0x2584;
+constexpr uint16 fullBlock = 0x2588;
+// Pixel of the half block canvas: 0 if empty, else pixelSet | foreground attributes
+constexpr uint8 pixelSet = 0x10;
+
+
+// Draws the rows [rowBegin, rowEnd) of an image with its top left corner at x0, y0 (world coordinates).
+// colors: per glyph colors, if null all glyphs use attrib
+void BlitImage(CharInfo* dst, const IVector2D& bounds, const Image& image, int x0, int y0, const byte* colors, uint16 attrib, int rowBegin, int rowEnd)
+{
+	// Clip
+	const int l = std::max(0, x0);
+	const int r = std::min(bounds.x, x0 + image.width);
+	const int b = std::max(rowBegin, y0);
+	const int t = std::min(rowEnd, y0 + image.height);
+
+	for (int y = b; y < t; ++y)
+	{
+		CharInfo* row = dst + (y + Renderer::hudRows) * bounds.x;
+		for (int x = l; x < r; ++x)
+		{
+			auto& c = row[x];
+			int s = (x - x0) + (y - y0) * (image.width + 1) + 1;  // +1: remove new lines, the first and at the end of each line
+			if (image.img[s] != ' ')
+			{
+				c.ch = static_cast<uint16>(image.img[s]);
+				c.attributes = colors ? charColors[colors[s] - '0'] : attrib;
+			}
+		}
+	}
+}
+
+
+
+// Same as BlitImage for an image made of half block glyphs only, drawn to a canvas with two pixels per
+// cell. y0 and rows are in pixels, the rows of each glyph go to pixels 2 * row and 2 * row + 1
+void BlitHalfBlocks(uint8* dst, const IVector2D& bounds, const Image& image, int x0, int y0, const byte* colors, uint16 attrib, int rowBegin, int rowEnd)
+{
+	const int l = std::max(0, x0);
+	const int r = std::min(bounds.x, x0 + image.width);
+	for (int iy = 0; iy < image.height; ++iy)
+	{
+		const int py = y0 + iy * 2;
+		if (py + 1 < rowBegin || py >= rowEnd)
+		{
+			continue;
+		}
+		uint8* top = (py >= rowBegin) ? dst + py * bounds.x : nullptr;
+		uint8* bottom = (py + 1 < rowEnd) ? dst + (py + 1) * bounds.x : nullptr;
+		for (int x = l; x < r; ++x)
+		{
+			const int s = (x - x0) + iy * (image.width + 1) + 1;
+			const wchar_t ch = image.img[s];
+			if (ch == ' ')
+			{
+				continue;
+			}
+			const uint8 pixel = pixelSet | (uint8)((colors ? charColors[colors[s] - '0'] : attrib) & foregroundMask);
+			if (top && ch != lowerHalf)
+			{
+				top[x] = pixel;
+			}
+			if (bottom && ch != upperHalf)
+			{
+				bottom[x] = pixel;
+			}
+		}
+	}
+}
+
+
+// Combines one pixel of top and one of bottom into a cell. Cells with no pixels set are kept
+inline uint32 PackHalfBlockCell(uint32 cell, uint32 top, uint32 bottom)
+{
+	if (!((top | bottom) & pixelSet))
+	{
+		return cell;
+	}
+	uint32 ch, attributes;
+	const uint32 background = (cell >> 16) & backgroundMask;
+	if (!(bottom & pixelSet))
+	{
+		ch = upperHalf;
+		attributes = (top & foregroundMask) | background;
+	}
+	else if (!(top & pixelSet))
+	{
+		ch = lowerHalf;
+		attributes = (bottom & foregroundMask) | background;
+	}
+	else if (top == bottom)
+	{
+		ch = fullBlock;
+		attributes = (top & foregroundMask) | background;
+	}
+	else
+	{
+		// Two colors: the bottom one is the background of an upper half block
+		ch = upperHalf;
+		attributes = (top & foregroundMask) | ((bottom & foregroundMask) << 4);
+	}
+	return ch | (attributes << 16) | (cell & 0xFF000000);
+}
+
+
+// Packs the pixel rows 2 * y and 2 * y + 1 into row y of cells, for y in [rowBegin, rowEnd)
+void PackHalfBlocks(CharInfo* cells, const uint8* pixels, int cols, int rowBegin, int rowEnd)
+{
+	static_assert(sizeof(CharInfo) == sizeof(uint32), "A cell is packed as ch | attributes << 16");
+	for (int y = rowBegin; y < rowEnd; ++y)
+	{
+		uint32* row = reinterpret_cast<uint32*>(cells + y * cols);
+		const uint8* top = pixels + 2 * y * cols;
+		const uint8* bottom = top + cols;
+		int x = 0;
+#if HALF_BLOCKS_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i setBit = _mm_set1_epi32(pixelSet);
+		const __m128i fgMask = _mm_set1_epi32(foregroundMask);
+		const __m128i bgMask = _mm_set1_epi32(backgroundMask << 16);
+		const __m128i highMask = _mm_set1_epi32((int)0xFF000000);
+		const __m128i upper = _mm_set1_epi32(upperHalf);
+		const __m128i lower = _mm_set1_epi32(lowerHalf);
+		const __m128i full = _mm_set1_epi32(fullBlock);
+		for (; x + 4 <= cols; x += 4)
+		{
+			uint32 t4, b4;
+			memcpy(&t4, top + x, 4);
+			memcpy(&b4, bottom + x, 4);
+			if (!(t4 | b4))
+			{
+				continue; // most of the canvas is empty
+			}
+			// Widen the 4 pixels to 32 bit lanes, one lane per cell
+			const __m128i t = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)t4), zero), zero);
+			const __m128i b = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)b4), zero), zero);
+			const __m128i cell = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			const __m128i tSet = _mm_cmpeq_epi32(_mm_and_si128(t, setBit), setBit);
+			const __m128i bSet = _mm_cmpeq_epi32(_mm_and_si128(b, setBit), setBit);
+			const __m128i both = _mm_and_si128(tSet, bSet);
+			const __m128i same = _mm_cmpeq_epi32(t, b);
+			const __m128i split = _mm_andnot_si128(same, both);
+			// Glyph: full if both pixels have the same color, lower if only the bottom one is set, else upper
+			__m128i ch = _mm_or_si128(_mm_and_si128(tSet, upper), _mm_andnot_si128(tSet, lower));
+			ch = _mm_or_si128(_mm_and_si128(_mm_and_si128(both, same), full), _mm_andnot_si128(_mm_and_si128(both, same), ch));
+			// Foreground from the top pixel if set, background from the bottom pixel for two colors
+			const __m128i fg = _mm_and_si128(_mm_or_si128(_mm_and_si128(tSet, t), _mm_andnot_si128(tSet, b)), fgMask);
+			const __m128i bg = _mm_or_si128(_mm_and_si128(split, _mm_slli_epi32(_mm_and_si128(b, fgMask), 20)), _mm_andnot_si128(split, _mm_and_si128(cell, bgMask)));
+			const __m128i packed = _mm_or_si128(_mm_or_si128(ch, _mm_slli_epi32(fg, 16)), _mm_or_si128(bg, _mm_and_si128(cell, highMask)));
+			const __m128i any = _mm_or_si128(tSet, bSet);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_or_si128(_mm_and_si128(any, packed), _mm_andnot_si128(any, cell)));
+		}
+#endif
+		for (; x < cols; ++x)
+		{
+			row[x] = PackHalfBlockCell(row[x], top[x], bottom[x]);
+		}
+	}
+}
+
 
+bool IsHalfBlockImage(const Image& image)
+{
+	for (int y = 0; y < image.height; ++y)
+	{
+		for (int x = 0; x < image.width; ++x)
+		{
+			const wchar_t ch = image.img[x + y * (image.width + 1) + 1];
+			if (ch != ' ' && ch != upperHalf && ch != lowerHalf && ch != fullBlock)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+int FloorDiv2(int v)
+{
+	return (v >= 0) ? v / 2 : -((1 - v) / 2);
+}
+
+}
+
+
+uint16 GetColorAttributes(Color color)
+{
+	return charColors[(int)color];
 }
 
 
 const int Renderer::hudRows = 2; // rows reserved for the HUD
 
 
-Renderer::Renderer(const IVector2D& bounds_, Console& console_) :
-	console {console_},
+Renderer::Renderer(const IVector2D& bounds_) :
 	bounds {bounds_}
 {
 	assert(bounds.x > 0);
@@ -54,6 +257,13 @@ Renderer::Renderer(const IVector2D& bounds_, Console& console_) :
 	const int consoleHeight = bounds.y + hudRows;
 	const size_t canvasSize = consoleWidth * consoleHeight;
 	canvas.resize(canvasSize);
+	target = canvas.data();
+	currentLayer = -1;
+	workerPool = nullptr;
+	cameraOffset = { 0, 0 };
+	halfBlocks = false;
+	detail = RenderDetail::full;
+	presentTime = 0.;
 }
 
 
@@ -66,20 +276,39 @@ const IVector2D& Renderer::GetBounds() const
 }
 
 
-bool Renderer::InitializeConsole(int fontSize)
+IVector2D Renderer::GetCanvasSize() const
 {
-	const int consoleWidth = bounds.x;
-	const int consoleHeight = bounds.y + hudRows;
-	bool r = ResizeConsole(console.handle, consoleWidth, consoleHeight, fontSize);
-	r = r && CenterConsoleOnDesktop();
-	return r;
+	return { bounds.x, bounds.y + hudRows };
+}
+
+
+void Renderer::AddPresenter(Presenter* presenter)
+{
+	assert(presenter);
+	presenters.push_back(presenter);
 }
 
 
-void Renderer::Update(const RenderItemList& sprites, const Game& game, const MessageLog& messageLog)
+void Renderer::RemovePresenter(Presenter* presenter)
 {
+	presenters.erase(std::remove(presenters.begin(), presenters.end(), presenter), presenters.end());
+}
+
+
+void Renderer::Update(const RenderItemList& sprites, const Game& game, const MessageLog& messageLog, float interpolation)
+{
+	PROFILE_ZONE("Renderer::Update");
 	FillCanvas(Color::black);
-	DrawSprites(sprites.data(), (int)sprites.size());
+	// Walls are static, they are redrawn only when one is added, hit or destroyed or when the camera moves
+	const uint wallsVersion = game.world.wallsVersion + GetImageVersion(ImageId::solidWall) + GetImageVersion(ImageId::brittleWall);
+	const uint64 wallsKey = ((uint64)wallsVersion << 32) | ((uint64)(uint16)cameraOffset.x << 16) | (uint16)cameraOffset.y;
+	if (BeginLayer((int)LayerId::walls, wallsKey))
+	{
+		game.world.GetWallRenderItems(wallItems);
+		DrawSprites(wallItems.data(), (int)wallItems.size());
+	}
+	EndLayer();
+	DrawSprites(sprites.data(), (int)sprites.size(), interpolation);
 	DisplayScores(game);
 	DisplayMessages(messageLog);
 	DrawGameState(game, *this);
@@ -93,7 +322,7 @@ void Renderer::DisplayScores(const Game& game)
 	char tmp[256];
 	for (int p = 0; p < game.numPlayers; ++p)
 	{
-		sprintf_s(tmp, "P%d Score: %d", p + 1, game.score[p]);
+		snprintf(tmp, sizeof(tmp), "P%d Score: %d", p + 1, game.score[p]);
 		DisplayText(tmp, 0, p, Color::white);
 	}
 }
@@ -101,10 +330,10 @@ void Renderer::DisplayScores(const Game& game)
 
 void Renderer::FillCanvas(Color color)
 {
-	CHAR_INFO* curCanvas = canvas.data();
-	CHAR_INFO ch; 
-	ch.Char.UnicodeChar = static_cast<WCHAR>(' ');
-	ch.Attributes = charColors[(int)color];
+	CharInfo* curCanvas = canvas.data();
+	CharInfo ch; 
+	ch.ch = static_cast<uint16>(' ');
+	ch.attributes = charColors[(int)color];
 	for (int i = 0, ei = (int)canvas.size(); i != ei; ++i)
 	{
 		curCanvas[i] = ch;
@@ -114,16 +343,28 @@ void Renderer::FillCanvas(Color color)
 
 void Renderer::DrawCanvas()
 {
-	WriteConsoleOutput(console.handle, canvas.data(), bounds.x, bounds.y, 0, hudRows);
+	const IVector2D canvasSize = GetCanvasSize();
+	const auto t0 = std::chrono::steady_clock::now();
+	for (Presenter* presenter : presenters)
+	{
+		presenter->Present(canvas.data(), canvasSize.x, canvasSize.y);
+	}
+	presentTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+
+double Renderer::GetPresentTime() const
+{
+	return presentTime;
 }
 
 
 void Renderer::ClearLine(int row)
 {
-	CHAR_INFO* curCanvas = canvas.data() + row * bounds.x;
-	CHAR_INFO ch; 
-	ch.Char.UnicodeChar = static_cast<WCHAR>(' ');
-	ch.Attributes = charColors[(int)Color::black];
+	CharInfo* curCanvas = target + row * bounds.x;
+	CharInfo ch; 
+	ch.ch = static_cast<uint16>(' ');
+	ch.attributes = charColors[(int)Color::black];
 	for (int x = 0, ex = bounds.x; x != ex; ++x)
 	{
 		curCanvas[x] = ch;
@@ -134,7 +375,7 @@ void Renderer::ClearLine(int row)
 void Renderer::DisplayText(const char* str, int col, int row, Color color, ImageAlignment hAlignment)
 {
 	assert(str);
-	CHAR_INFO* curCanvas = canvas.data() + row * bounds.x;
+	CharInfo* curCanvas = target + row * bounds.x;
 	if (hAlignment == ImageAlignment::centered)
 	{
 		col = (bounds.x - (int)strlen(str)) / 2 + col;
@@ -143,35 +384,155 @@ void Renderer::DisplayText(const char* str, int col, int row, Color color, Image
 	{
 		if (col >= 0 && col < bounds.x)
 		{
-			curCanvas[i + col].Char.UnicodeChar = static_cast<CHAR>(str[i]);
-			curCanvas[i + col].Attributes = charColors[(int)color];
+			curCanvas[i + col].ch = static_cast<uint16>(str[i]);
+			curCanvas[i + col].attributes = charColors[(int)color];
 		}
 	}
 }
 
 
-void Renderer::DrawSprites(const RenderItem* sprites, int count)
+void Renderer::DrawSprites(const RenderItem* sprites, int count, float interpolation)
 {
-	for (int i = 0; i < count; ++i)
+	// Draw order is given by the layer of the items, not by their order in the list
+	SortRenderItems(sprites, count, sortOrder, sortTemp);
+	// Resolve position, image and colors of the items in draw order
+	// In half block mode the sprites made of half block glyphs only move by half rows. They are drawn to
+	// the pixel canvas, which is then packed into the cells. Layers are always drawn in whole cells
+	const bool usePixels = halfBlocks && target == canvas.data();
+	const RenderDetail spriteDetail = target == canvas.data() ? detail : RenderDetail::full;
+	if (usePixels)
 	{
-		const auto& ri = sprites[i];
-		int x = (int)std::floor(ri.pos.x);
-		int y = (int)std::floor(ri.pos.y);
-		const Image& image = GetImage(ri.visual.imageId);
+		std::fill(pixels.begin(), pixels.end(), (uint8)0);
+	}
+	const Image* batchImage = nullptr;
+	ImageId batchImageId = ImageId::null;
+	bool batchHalfBlock = false;
+	spriteBlits.clear();
+	for (const uint32 entry : sortOrder)
+	{
+		const auto& ri = sprites[entry & 0xFFFF];
+		if (spriteDetail != RenderDetail::full && ri.layer == RenderLayer::explosions)
+		{
+			continue;
+		}
+		const Vector2D pos = Lerp(ri.prevPos, ri.pos, interpolation);
+		// Items sharing an image are consecutive, look the image up once per batch
+		if (! batchImage || ri.visual.imageId != batchImageId)
+		{
+			batchImage = &GetImage(ri.visual.imageId);
+			batchImageId = ri.visual.imageId;
+			batchHalfBlock = usePixels && batchImage->img && IsHalfBlockImage(*batchImage);
+		}
+		const Image& image = *batchImage;
 		if (image.img)
 		{
-			x -= image.width / 2;
-			y -= image.height / 2;
-			if (image.colors)
-			{
-				DrawColoredImage(image, x, y);
-			}
-			else
+			const int x = (int)std::floor(pos.x) - cameraOffset.x - image.width / 2;
+			const int y = batchHalfBlock ?
+				(int)std::floor(pos.y * 2.f) - (cameraOffset.y + image.height / 2) * 2 :
+				(int)std::floor(pos.y) - cameraOffset.y - image.height / 2;
+			const byte* colors = spriteDetail == RenderDetail::flat ? nullptr : image.colors;
+			spriteBlits.push_back( { &image, x, y, colors, charColors[(int)ri.visual.color], batchHalfBlock } );
+		}
+	}
+
+	int numBands = 1;
+	if (workerPool && bounds.x * bounds.y >= minParallelCells && (int)spriteBlits.size() >= minParallelSprites)
+	{
+		// A few bands per thread to balance the load
+		numBands = std::min(workerPool->GetNumThreads() * 2, bounds.y / minBandHeight);
+	}
+	if (numBands <= 1)
+	{
+		for (const auto& blit : spriteBlits)
+		{
+			RasterizeSprite(blit, 0, bounds.y);
+		}
+		if (usePixels)
+		{
+			PackHalfBlocks(canvas.data() + hudRows * bounds.x, pixels.data(), bounds.x, 0, bounds.y);
+		}
+		return;
+	}
+
+	// Bin the sprites by the bands their clipped vertical extent overlaps. Bins keep the draw order, so
+	// the overlap order within a band is the same as in the serial path
+	const int bandHeight = (bounds.y + numBands - 1) / numBands;
+	numBands = (bounds.y + bandHeight - 1) / bandHeight;
+	spriteBands.resize(numBands);
+	for (auto& band : spriteBands)
+	{
+		band.clear();
+	}
+	for (int i = 0, n = (int)spriteBlits.size(); i < n; ++i)
+	{
+		const auto& blit = spriteBlits[i];
+		const int y0 = std::max(0, blit.halfBlock ? FloorDiv2(blit.y) : blit.y);
+		const int y1 = std::min(bounds.y, blit.halfBlock ? FloorDiv2(blit.y + blit.image->height * 2 + 1) : blit.y + blit.image->height);
+		if (y0 < y1)
+		{
+			for (int band = y0 / bandHeight, lastBand = (y1 - 1) / bandHeight; band <= lastBand; ++band)
 			{
-				DrawImage(image, x, y, ri.visual.color, ImageAlignment::left,  ImageAlignment::top);
+				spriteBands[band].push_back(i);
 			}
 		}
 	}
+	workerPool->ParallelFor(numBands, [this, bandHeight, usePixels](int band)
+	{
+		const int rowBegin = band * bandHeight;
+		const int rowEnd = std::min(bounds.y, rowBegin + bandHeight);
+		for (int i : spriteBands[band])
+		{
+			RasterizeSprite(spriteBlits[i], rowBegin, rowEnd);
+		}
+		if (usePixels)
+		{
+			PackHalfBlocks(canvas.data() + hudRows * bounds.x, pixels.data(), bounds.x, rowBegin, rowEnd);
+		}
+	});
+}
+
+
+void Renderer::RasterizeSprite(const SpriteBlit& blit, int rowBegin, int rowEnd)
+{
+	if (blit.halfBlock)
+	{
+		BlitHalfBlocks(pixels.data(), bounds, *blit.image, blit.x, blit.y, blit.colors, blit.attributes, rowBegin * 2, rowEnd * 2);
+	}
+	else
+	{
+		BlitImage(target, bounds, *blit.image, blit.x, blit.y, blit.colors, blit.attributes, rowBegin, rowEnd);
+	}
+}
+
+
+void Renderer::SetCamera(const Vector2D& pos)
+{
+	cameraOffset = { (int)std::floor(pos.x), (int)std::floor(pos.y) };
+}
+
+
+void Renderer::SetDetail(RenderDetail detail_)
+{
+	detail = detail_;
+}
+
+
+RenderDetail Renderer::GetDetail() const
+{
+	return detail;
+}
+
+
+void Renderer::SetHalfBlocks(bool enable)
+{
+	halfBlocks = enable;
+	pixels.assign(enable ? bounds.x * bounds.y * 2 : 0, 0);
+}
+
+
+void Renderer::SetWorkerPool(WorkerPool* pool)
+{
+	workerPool = pool;
 }
 
 
@@ -188,7 +549,6 @@ void Renderer::DisplayMessages(const MessageLog& messageLog)
 
 void Renderer::DrawImage(const Image& image, int x0, int y0, Color color, ImageAlignment hAlignment, ImageAlignment vAlignment)
 {
-	CHAR_INFO* const dst = canvas.data();
 	if (hAlignment == ImageAlignment::centered)
 	{
 		x0 = (bounds.x - image.width) / 2 + x0;
@@ -205,57 +565,120 @@ void Renderer::DrawImage(const Image& image, int x0, int y0, Color color, ImageA
 	{
 		y0 = bounds.y- image.height - y0;
 	}
-	// Clip
+	BlitImage(target, bounds, image, x0, y0, nullptr, charColors[(int)color], 0, bounds.y);
+}
+
+
+void Renderer::DrawColoredImage(const Image& image, int x0, int y0)
+{
+	BlitImage(target, bounds, image, x0, y0, image.colors, 0, 0, bounds.y);
+}
+
+
+void Renderer::DrawCells(const CharInfo* cells, int cols, int rows, int x0, int y0)
+{
 	const int l = std::max(0, x0);
-	const int r = std::min(bounds.x, x0 + image.width);
+	const int r = std::min(bounds.x, x0 + cols);
 	const int b = std::max(0, y0);
-	const int t = std::min(bounds.y, y0 + image.height);
-	const WORD attrib = charColors[(int)color];
-
+	const int t = std::min(bounds.y, y0 + rows);
 	for (int y = b; y < t; ++y)
 	{
+		CharInfo* dst = target + (y + hudRows) * bounds.x;
+		const CharInfo* src = cells + (y - y0) * cols - x0;
 		for (int x = l; x < r; ++x)
 		{
-			auto& c = dst[x + (y + hudRows) * bounds.x];
-			int s = (x - x0) + (y - y0) * (image.width + 1) + 1;  // +1: remove new lines, the first and at the end of each line
-			if (image.img[s] != ' ')
+			if (src[x].ch != ' ')
 			{
-				c.Char.UnicodeChar = static_cast<WCHAR>(image.img[s]);
-				c.Attributes = attrib;
+				dst[x] = src[x];
 			}
 		}
 	}
 }
 
 
-void Renderer::DrawColoredImage(const Image& image, int x0, int y0)
+bool Renderer::BeginLayer(int layerId, uint64 key)
 {
-	CHAR_INFO* const dst = canvas.data();
-	// Clip
-	const int l = std::max(0, x0);
-	const int r = std::min(bounds.x, x0 + image.width);
-	const int b = std::max(0, y0);
-	const int t = std::min(bounds.y, y0 + image.height);
+	assert(layerId >= 0);
+	assert(currentLayer < 0); // layers can't be nested
+	if (layerId >= (int)layers.size())
+	{
+		layers.resize(layerId + 1);
+	}
+	Layer& layer = layers[layerId];
+	currentLayer = layerId;
+	if (layer.valid && layer.key == key)
+	{
+		return false;
+	}
+	layer.cells.assign(canvas.size(), CharInfo { 0, 0 });
+	layer.key = key;
+	layer.valid = true;
+	target = layer.cells.data();
+	return true;
+}
 
-	for (int y = b; y < t; ++y)
+
+void Renderer::EndLayer()
+{
+	assert(currentLayer >= 0);
+	Layer& layer = layers[currentLayer];
+	const int cols = bounds.x;
+	const int rows = (int)canvas.size() / cols;
+	if (target != canvas.data())
 	{
-		for (int x = l; x < r; ++x)
+		// The layer has been redrawn, find the non transparent span of each row
+		layer.spans.resize(rows);
+		for (int y = 0; y < rows; ++y)
 		{
-			auto& c = dst[x + (y + hudRows) * bounds.x];
-			int s = (x - x0) + (y - y0) * (image.width + 1) + 1;  // +1: remove new lines, the first and at the end of each line
-			if (image.img[s] != ' ')
+			const CharInfo* row = layer.cells.data() + y * cols;
+			int begin = 0;
+			int end = cols;
+			while (begin < end && row[begin].ch == 0)
+			{
+				++begin;
+			}
+			while (end > begin && row[end - 1].ch == 0)
+			{
+				--end;
+			}
+			bool opaque = true;
+			for (int x = begin; x < end && opaque; ++x)
+			{
+				opaque = row[x].ch != 0;
+			}
+			layer.spans[y] = { begin, end, opaque };
+		}
+		target = canvas.data();
+	}
+
+	// Composite
+	for (int y = 0; y < rows; ++y)
+	{
+		const LayerSpan& span = layer.spans[y];
+		const CharInfo* src = layer.cells.data() + y * cols;
+		CharInfo* dst = canvas.data() + y * cols;
+		if (span.opaque)
+		{
+			std::copy(src + span.begin, src + span.end, dst + span.begin);
+		}
+		else
+		{
+			for (int x = span.begin; x < span.end; ++x)
 			{
-				c.Char.UnicodeChar = static_cast<WCHAR>(image.img[s]);
-				c.Attributes = charColors[image.colors[s] - '0'];
+				if (src[x].ch)
+				{
+					dst[x] = src[x];
+				}
 			}
 		}
 	}
+	currentLayer = -1;
 }
 
 
 void DrawImage(Renderer& renderer, const ImageA& image, int x0, int y0, Color color, ImageAlignment hAlignment, ImageAlignment vAlignment)
 {
-	CHAR_INFO* const dst = renderer.canvas.data();
+	CharInfo* const dst = renderer.target;
 	IVector2D bounds = renderer.bounds;
 	if (hAlignment == ImageAlignment::centered)
 	{
@@ -278,7 +701,7 @@ void DrawImage(Renderer& renderer, const ImageA& image, int x0, int y0, Color co
 	const int r = std::min(bounds.x, x0 + image.width);
 	const int b = std::max(0, y0);
 	const int t = std::min(bounds.y, y0 + image.height);
-	const WORD attrib = charColors[(int)color];
+	const uint16 attrib = charColors[(int)color];
 
 	for (int y = b; y < t; ++y)
 	{
@@ -288,8 +711,8 @@ void DrawImage(Renderer& renderer, const ImageA& image, int x0, int y0, Color co
 			int s = (x - x0) + (y - y0) * (image.width);
 			if (image.img[s] != ' ')
 			{
-				c.Char.UnicodeChar = static_cast<WCHAR>(image.img[s]);
-				c.Attributes = attrib;
+				c.ch = static_cast<uint16>(image.img[s]);
+				c.attributes = attrib;
 			}
 		}
 	}
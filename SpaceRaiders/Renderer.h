@@ -3,15 +3,16 @@
 #include <vector>
 #include "Vector2D.h"
 #include "RenderItem.h"
+#include "CharInfo.h"
 
 
-typedef struct _CHAR_INFO CHAR_INFO; // forward declaration of C struct
 typedef std::vector<RenderItem> RenderItemList;
 struct Game;
 class MessageLog;
 struct Image;
 struct ImageA;
-struct Console;
+class Presenter;
+class WorkerPool;
 
 
 enum class ImageAlignment
@@ -24,39 +25,116 @@ enum class ImageAlignment
 };
 
 
+// Render detail, lowered by the frame scheduler when rendering does not fit the frame budget
+enum class RenderDetail
+{
+	full,
+	noParticles, // explosions are not drawn
+	flat,        // no particles, sprites drawn in their color instead of per glyph colors
+	count
+};
+
+
 class Renderer
 {
 public:
 
-	Renderer(const IVector2D& bounds, Console& console);
+	Renderer(const IVector2D& bounds);
 	~Renderer();
 
 	const IVector2D& GetBounds() const;
-	bool InitializeConsole(int fontSize);
+	// Canvas size including the HUD rows
+	IVector2D GetCanvasSize() const;
+	// Finished canvases are sent to all the presenters (console, memory, capture file...)
+	void AddPresenter(Presenter* presenter);
+	void RemovePresenter(Presenter* presenter);
 	// Display all game objects, score, game over message
-	void Update(const RenderItemList& sprites, const Game& game, const MessageLog& messageLog);
+	// interpolation: [0,1] fraction between the previous and current simulation step
+	void Update(const RenderItemList& sprites, const Game& game, const MessageLog& messageLog, float interpolation = 1.f);
 
 	// Fills whole canvas array with sprite
 	void FillCanvas(Color color);
 
-	// Prints canvas char array on console
+	// Sends canvas char array to the presenters
 	void DrawCanvas();
+	// Time spent by the last DrawCanvas [s]
+	double GetPresentTime() const;
 
 	void ClearLine(int row);
 	void DisplayText(const char* str, int col, int row, Color color, ImageAlignment hAlignment = ImageAlignment::left);
 	void DisplayMessages(const MessageLog& messageLog);
 	void DrawImage(const Image& image, int x, int y, Color color, ImageAlignment hAlignment, ImageAlignment vAlignment);
 	void DrawColoredImage(const Image& image, int x, int y);
+	// Copies a block of cells, e.g. a video frame. Blanks are transparent as in images
+	void DrawCells(const CharInfo* cells, int cols, int rows, int x, int y);
 	void DisplayScores(const Game& game);
-	void DrawSprites(const RenderItem* sprites, int count);
+	// Large canvases with many sprites are split in horizontal bands rasterized in parallel
+	void DrawSprites(const RenderItem* sprites, int count, float interpolation = 1.f);
+	void SetWorkerPool(WorkerPool* pool);
+	// Half block mode: sprites drawn with half block glyphs move by half rows, the canvas has two
+	// pixels per cell that are packed into half block glyphs with foreground and background colors
+	void SetHalfBlocks(bool enable);
+	// Top left corner of the view in world coordinates, sprites are drawn relative to it
+	void SetCamera(const Vector2D& pos);
+	// Applies to the sprites drawn to the canvas, cached layers are always drawn in full
+	void SetDetail(RenderDetail detail);
+	RenderDetail GetDetail() const;
+
+	// Retained layers. Draw calls between BeginLayer and EndLayer go to a cached canvas that is redrawn
+	// only when its key changes, in which case BeginLayer returns true. EndLayer composites the layer
+	// over the canvas
+	bool BeginLayer(int layerId, uint64 key);
+	void EndLayer();
 
 public:
 
 	static const int hudRows;
 
-	Console& console;
+	// Non transparent cells of a layer row
+	struct LayerSpan
+	{
+		int  begin;
+		int  end;
+		bool opaque; // no transparent cells in [begin, end)
+	};
+
+	struct Layer
+	{
+		std::vector<CharInfo>  cells; // ch == 0 is transparent
+		std::vector<LayerSpan> spans; // one per row
+		uint64                 key;
+		bool                   valid;
+	};
+
 	IVector2D bounds;
-	std::vector<CHAR_INFO> canvas;
+	IVector2D cameraOffset;
+	std::vector<CharInfo> canvas;
+	CharInfo* target; // canvas or layer being drawn
+	std::vector<Layer> layers;
+	int currentLayer;
+	RenderItemList wallItems;
+	std::vector<uint32> sortOrder;
+	std::vector<uint32> sortTemp;
+
+	// Sprite in draw order, ready to be rasterized
+	struct SpriteBlit
+	{
+		const Image* image;
+		int          x;
+		int          y;
+		const byte*  colors;     // per glyph colors or null
+		uint16       attributes; // used if colors is null
+		bool         halfBlock;  // drawn to the pixel canvas, y is in pixels
+	};
+	void RasterizeSprite(const SpriteBlit& blit, int rowBegin, int rowEnd);
+	std::vector<SpriteBlit> spriteBlits;
+	std::vector<std::vector<int>> spriteBands; // indices of the sprites overlapping each band
+	std::vector<uint8> pixels; // half block mode only, bounds.x * bounds.y * 2
+	bool halfBlocks;
+	RenderDetail detail;
+	WorkerPool* workerPool; // optional
+	std::vector<Presenter*> presenters;
+	double presentTime;
 };
 
 
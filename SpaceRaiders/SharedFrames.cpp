@@ -0,0 +1,403 @@
+#include "SharedFrames.h"
+#include "TerminalPresenter.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <cassert>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+constexpr uint32 sharedFramesMagic = 0x53524642; // "SRFB"
+constexpr uint32 sharedFramesVersion = 1;
+
+// Layout of the shared block: header, then numSlots slots of slotSize bytes
+struct SharedFramesHeader
+{
+	uint32              magic;
+	uint32              version;
+	uint32              numSlots;
+	uint32              slotSize;
+	uint32              cols;
+	uint32              rows;
+	std::atomic<uint32> alive;     // cleared by the publisher on close
+	uint32              pad;
+	std::atomic<uint64> lastFrame; // number of the last published frame, 0: none yet
+};
+
+struct SharedFrameSlot
+{
+	std::atomic<uint64> sequence;  // odd while the slot is written
+	uint64              frame;
+	// followed by cols * rows cells
+};
+
+static_assert(std::atomic<uint64>::is_always_lock_free, "Shared frames need lock free 64 bit atomics");
+
+constexpr size_t headerSize = (sizeof(SharedFramesHeader) + 63) & ~size_t(63);
+
+
+SharedFramesHeader* GetHeader(const SharedMemory& memory)
+{
+	return static_cast<SharedFramesHeader*>(memory.GetData());
+}
+
+
+SharedFrameSlot* GetSlot(const SharedMemory& memory, uint64 frame)
+{
+	SharedFramesHeader* header = GetHeader(memory);
+	byte* base = static_cast<byte*>(memory.GetData()) + headerSize;
+	return reinterpret_cast<SharedFrameSlot*>(base + (frame % header->numSlots) * header->slotSize);
+}
+
+
+CharInfo* GetCells(SharedFrameSlot* slot)
+{
+	return reinterpret_cast<CharInfo*>(slot + 1);
+}
+
+}
+
+
+SharedMemory::SharedMemory() :
+	data { nullptr },
+	size { 0 },
+	handle { nullptr },
+	owner { false },
+	name { }
+{}
+
+
+SharedMemory::~SharedMemory()
+{
+	Close();
+}
+
+
+#if defined(_WIN32)
+
+bool SharedMemory::Create(const char* name_, size_t size_)
+{
+	assert(!data);
+	snprintf(name, sizeof(name), "Local\\%s", name_);
+	HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64)size_ >> 32), (DWORD)size_, name);
+	if (!h)
+	{
+		return false;
+	}
+	data = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+	if (!data)
+	{
+		CloseHandle(h);
+		return false;
+	}
+	handle = h;
+	size = size_;
+	owner = true;
+	return true;
+}
+
+
+bool SharedMemory::Open(const char* name_)
+{
+	assert(!data);
+	snprintf(name, sizeof(name), "Local\\%s", name_);
+	HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (!h)
+	{
+		return false;
+	}
+	data = MapViewOfFile(h, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(h);
+		return false;
+	}
+	MEMORY_BASIC_INFORMATION info;
+	VirtualQuery(data, &info, sizeof(info));
+	handle = h;
+	size = info.RegionSize;
+	owner = false;
+	return true;
+}
+
+
+void SharedMemory::Close()
+{
+	if (data)
+	{
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)handle);
+	}
+	data = nullptr;
+	handle = nullptr;
+	size = 0;
+}
+
+#else
+
+bool SharedMemory::Create(const char* name_, size_t size_)
+{
+	assert(!data);
+	snprintf(name, sizeof(name), "/%s", name_);
+	const int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0)
+	{
+		return false;
+	}
+	void* p = (ftruncate(fd, (off_t)size_) == 0) ? mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (p == MAP_FAILED)
+	{
+		shm_unlink(name);
+		return false;
+	}
+	data = p;
+	size = size_;
+	owner = true;
+	return true;
+}
+
+
+bool SharedMemory::Open(const char* name_)
+{
+	assert(!data);
+	snprintf(name, sizeof(name), "/%s", name_);
+	const int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	void* p = (fstat(fd, &st) == 0 && st.st_size > 0) ? mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+	close(fd);
+	if (p == MAP_FAILED)
+	{
+		return false;
+	}
+	data = p;
+	size = (size_t)st.st_size;
+	owner = false;
+	return true;
+}
+
+
+void SharedMemory::Close()
+{
+	if (data)
+	{
+		munmap(data, size);
+		if (owner)
+		{
+			shm_unlink(name);
+		}
+	}
+	data = nullptr;
+	size = 0;
+}
+
+#endif
+
+
+void* SharedMemory::GetData() const
+{
+	return data;
+}
+
+
+size_t SharedMemory::GetSize() const
+{
+	return size;
+}
+
+
+SharedFramePublisher::SharedFramePublisher() :
+	frameCount { 0 }
+{}
+
+
+SharedFramePublisher::~SharedFramePublisher()
+{
+	Close();
+}
+
+
+bool SharedFramePublisher::Open(const char* name, int cols, int rows, int numSlots)
+{
+	assert(cols > 0 && rows > 0 && numSlots > 0);
+	const size_t slotSize = (sizeof(SharedFrameSlot) + (size_t)cols * rows * sizeof(CharInfo) + 63) & ~size_t(63);
+	if (!memory.Create(name, headerSize + slotSize * numSlots))
+	{
+		return false;
+	}
+	SharedFramesHeader* header = GetHeader(memory);
+	header->magic = sharedFramesMagic;
+	header->version = sharedFramesVersion;
+	header->numSlots = (uint32)numSlots;
+	header->slotSize = (uint32)slotSize;
+	header->cols = (uint32)cols;
+	header->rows = (uint32)rows;
+	header->lastFrame.store(0, std::memory_order_relaxed);
+	for (int i = 0; i < numSlots; ++i)
+	{
+		GetSlot(memory, i)->sequence.store(0, std::memory_order_relaxed);
+	}
+	header->alive.store(1, std::memory_order_release);
+	frameCount = 0;
+	return true;
+}
+
+
+void SharedFramePublisher::Close()
+{
+	if (IsOpen())
+	{
+		GetHeader(memory)->alive.store(0, std::memory_order_release);
+	}
+	memory.Close();
+}
+
+
+bool SharedFramePublisher::IsOpen() const
+{
+	return memory.GetData() != nullptr;
+}
+
+
+void SharedFramePublisher::Present(const CharInfo* canvas, int cols, int rows)
+{
+	SharedFramesHeader* header = GetHeader(memory);
+	if (!header || (uint32)cols != header->cols || (uint32)rows != header->rows)
+	{
+		return;
+	}
+	const uint64 frame = ++frameCount;
+	SharedFrameSlot* slot = GetSlot(memory, frame);
+	const uint64 seq = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot->frame = frame;
+	memcpy(GetCells(slot), canvas, (size_t)cols * rows * sizeof(CharInfo));
+	slot->sequence.store(seq + 2, std::memory_order_release);
+	header->lastFrame.store(frame, std::memory_order_release);
+}
+
+
+SharedFrameReader::SharedFrameReader() :
+	lastFrame { 0 }
+{}
+
+
+bool SharedFrameReader::Open(const char* name)
+{
+	if (!memory.Open(name))
+	{
+		return false;
+	}
+	const SharedFramesHeader* header = GetHeader(memory);
+	if (memory.GetSize() < headerSize || header->magic != sharedFramesMagic || header->version != sharedFramesVersion
+		|| memory.GetSize() < headerSize + (size_t)header->slotSize * header->numSlots)
+	{
+		memory.Close();
+		return false;
+	}
+	lastFrame = 0;
+	return true;
+}
+
+
+void SharedFrameReader::Close()
+{
+	memory.Close();
+}
+
+
+bool SharedFrameReader::IsAlive() const
+{
+	return memory.GetData() && GetHeader(memory)->alive.load(std::memory_order_acquire) != 0;
+}
+
+
+int SharedFrameReader::GetCols() const
+{
+	return (int)GetHeader(memory)->cols;
+}
+
+
+int SharedFrameReader::GetRows() const
+{
+	return (int)GetHeader(memory)->rows;
+}
+
+
+bool SharedFrameReader::ReadLatest(std::vector<CharInfo>& out, uint64& frameNumber)
+{
+	const SharedFramesHeader* header = GetHeader(memory);
+	const uint64 frame = header->lastFrame.load(std::memory_order_acquire);
+	if (frame == 0 || frame == lastFrame)
+	{
+		return false;
+	}
+	SharedFrameSlot* slot = GetSlot(memory, frame);
+	const uint64 seq = slot->sequence.load(std::memory_order_acquire);
+	if (seq & 1)
+	{
+		return false;
+	}
+	const size_t numCells = (size_t)header->cols * header->rows;
+	out.resize(numCells);
+	const uint64 slotFrame = slot->frame;
+	memcpy(out.data(), GetCells(slot), numCells * sizeof(CharInfo));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (slot->sequence.load(std::memory_order_relaxed) != seq)
+	{
+		return false;
+	}
+	lastFrame = frame;
+	frameNumber = slotFrame;
+	return true;
+}
+
+
+int RunFrameViewer(const char* name)
+{
+	SharedFrameReader reader;
+	// Wait for the game to start
+	for (int attempt = 0; !reader.Open(name); ++attempt)
+	{
+		if (attempt == 0)
+		{
+			fprintf(stderr, "Waiting for frames '%s'...\n", name);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	}
+	TerminalPresenter presenter { stdout };
+	std::vector<CharInfo> frame;
+	uint64 frameNumber = 0;
+	while (reader.IsAlive())
+	{
+		if (reader.ReadLatest(frame, frameNumber))
+		{
+			presenter.Present(frame.data(), reader.GetCols(), reader.GetRows());
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(4));
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Base.h"
+#include "Presenter.h"
+#include "CharInfo.h"
+#include <vector>
+#include <cstddef>
+
+
+// Named shared memory block: POSIX shm on Unix, a page file backed mapping on Windows
+class SharedMemory
+{
+public:
+
+	SharedMemory();
+	~SharedMemory();
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	bool Create(const char* name, size_t size);
+	bool Open(const char* name);
+	void Close();
+
+	void*  GetData() const;
+	size_t GetSize() const;
+
+private:
+
+	void*  data;
+	size_t size;
+	void*  handle;
+	bool   owner;      // the creator removes the name on close
+	char   name[64];
+};
+
+
+// Publishes every presented frame to a ring of frame slots in shared memory, so that external viewers
+// can watch the game. Each slot is guarded by a sequence lock: the game never waits for the viewers,
+// a viewer that reads a slot while it is overwritten sees the sequence change and tries again
+class SharedFramePublisher final : public Presenter
+{
+public:
+
+	SharedFramePublisher();
+	~SharedFramePublisher();
+
+	bool Open(const char* name, int cols, int rows, int numSlots);
+	void Close();
+	bool IsOpen() const;
+
+	void Present(const CharInfo* canvas, int cols, int rows) override;
+
+private:
+
+	SharedMemory memory;
+	uint64       frameCount;
+};
+
+
+// Reads the frames published by a SharedFramePublisher, possibly in another process
+class SharedFrameReader
+{
+public:
+
+	SharedFrameReader();
+
+	bool Open(const char* name);
+	void Close();
+	// False when the publisher has closed the ring
+	bool IsAlive() const;
+	int GetCols() const;
+	int GetRows() const;
+
+	// Copies the most recent frame to out if it is newer than the last one read. Returns false if there
+	// is no new frame or the frame was overwritten while being copied
+	bool ReadLatest(std::vector<CharInfo>& out, uint64& frameNumber);
+
+private:
+
+	SharedMemory memory;
+	uint64       lastFrame;
+};
+
+
+// Draws the frames of a running game on this terminal until the game exits
+int RunFrameViewer(const char* name);
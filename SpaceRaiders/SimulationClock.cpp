@@ -0,0 +1,175 @@
+#include "SimulationClock.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+namespace
+{
+
+SimulationClock::Duration ToDuration(double seconds)
+{
+	return std::chrono::duration_cast<SimulationClock::Duration>(std::chrono::duration<double>(seconds));
+}
+
+}
+
+
+SimulationClock::SimulationClock() :
+	stepTime { 0 },
+	accumTime { 0 },
+	stepsPerFrame { 1. },
+	scale { 1.f },
+	decimationScale { 0.f },
+	catchUpSteps { 1 },
+	keepBacklog { false },
+	maxSteps { 2 },
+	renderInterval { 1 },
+	frameCount { 0 },
+	lastDroppedSteps { 0 },
+	droppedSteps { 0 },
+	cappedFrames { 0 }
+{
+}
+
+
+void SimulationClock::Start(double stepTime_, double frameTime, int catchUpSteps_, float decimationScale_)
+{
+	assert(stepTime_ > 0. && frameTime > 0.);
+	assert(catchUpSteps_ >= 0);
+	stepTime = ToDuration(stepTime_);
+	accumTime = Duration { 0 };
+	stepsPerFrame = frameTime / stepTime_;
+	catchUpSteps = catchUpSteps_;
+	decimationScale = decimationScale_;
+	frameCount = 0;
+	lastDroppedSteps = 0;
+	droppedSteps = 0;
+	cappedFrames = 0;
+	UpdateLimits();
+}
+
+
+void SimulationClock::SetScale(float scale_)
+{
+	scale = std::min(maxScale, std::max(minScale, scale_));
+	UpdateLimits();
+}
+
+
+float SimulationClock::GetScale() const
+{
+	return scale;
+}
+
+
+void SimulationClock::Faster()
+{
+	SetScale(scale * 2.f);
+}
+
+
+void SimulationClock::Slower()
+{
+	SetScale(scale * .5f);
+}
+
+
+void SimulationClock::SetKeepBacklog(bool keep)
+{
+	keepBacklog = keep;
+}
+
+
+int SimulationClock::Advance(Duration elapsed)
+{
+	++frameCount;
+	accumTime += Duration { (Duration::rep)((double)elapsed.count() * scale) };
+	// Steps while more than one step is left, as the accumulator always keeps a partial step
+	int steps = accumTime.count() > 0 ? (int)std::min<Duration::rep>((accumTime.count() - 1) / stepTime.count(), 0x7FFFFFFF) : 0;
+	lastDroppedSteps = 0;
+	if (keepBacklog)
+	{
+		steps = std::min(steps, maxSteps);
+		accumTime -= stepTime * steps;
+		return steps;
+	}
+	accumTime -= stepTime * steps;
+	if (steps > maxSteps)
+	{
+		// The time of the dropped steps is lost, the game slows down instead of rushing
+		lastDroppedSteps = steps - maxSteps;
+		droppedSteps += lastDroppedSteps;
+		++cappedFrames;
+		steps = maxSteps;
+	}
+	return steps;
+}
+
+
+int SimulationClock::AdvanceIdle(Duration idle)
+{
+	accumTime += Duration { (Duration::rep)((double)idle.count() * scale) };
+	const int steps = GetBacklog();
+	accumTime -= stepTime * steps;
+	return steps;
+}
+
+
+int SimulationClock::GetBacklog() const
+{
+	return accumTime.count() > 0 ? (int)std::min<Duration::rep>((accumTime.count() - 1) / stepTime.count(), 0x7FFFFFFF) : 0;
+}
+
+
+int SimulationClock::TakeBacklog(int count)
+{
+	const int steps = std::max(0, std::min(count, GetBacklog()));
+	accumTime -= stepTime * steps;
+	return steps;
+}
+
+
+float SimulationClock::GetInterpolation() const
+{
+	return std::min(1.f, (float)accumTime.count() / (float)stepTime.count());
+}
+
+
+bool SimulationClock::ShouldRender() const
+{
+	return frameCount == 0 || (frameCount - 1) % renderInterval == 0;
+}
+
+
+int SimulationClock::GetMaxSteps() const
+{
+	return maxSteps;
+}
+
+
+int SimulationClock::GetLastDroppedSteps() const
+{
+	return lastDroppedSteps;
+}
+
+
+uint64 SimulationClock::GetDroppedSteps() const
+{
+	return droppedSteps;
+}
+
+
+uint64 SimulationClock::GetCappedFrames() const
+{
+	return cappedFrames;
+}
+
+
+void SimulationClock::UpdateLimits()
+{
+	// The share of the frame at this scale, plus the catch up steps. Rounded up so slow motion still
+	// runs a step when one is due
+	maxSteps = (int)std::ceil(stepsPerFrame * scale - 1e-6) + catchUpSteps;
+	renderInterval = decimationScale > 0.f && scale > decimationScale ? (int)std::ceil(scale / decimationScale) : 1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Base.h"
+#include <chrono>
+
+
+// Decides how many fixed simulation steps each presented frame runs. The step time never changes, the
+// time scale changes how much simulation time a real second is worth, so a fast forwarded or slowed
+// down game plays exactly the same steps as a real time one. Steps beyond the per frame cap are
+// dropped (e.g. after a breakpoint) and counted, or kept as a backlog for the frame scheduler
+class SimulationClock
+{
+public:
+
+	typedef std::chrono::steady_clock::duration Duration;
+
+	static constexpr float minScale = 1.f / 16.f;
+	static constexpr float maxScale = 64.f;
+
+	SimulationClock();
+
+	// stepTime and frameTime in seconds. catchUpSteps: steps a frame may run beyond its share to catch
+	// up. Above decimationScale, frames are rendered less often to leave the time to the simulation
+	void Start(double stepTime, double frameTime, int catchUpSteps, float decimationScale);
+
+	// Simulation seconds per real second, clamped to [minScale, maxScale]
+	void SetScale(float scale);
+	float GetScale() const;
+	void Faster(); // doubles the scale
+	void Slower(); // halves the scale
+
+	// Steps over the cap are kept for later frames instead of being dropped
+	void SetKeepBacklog(bool keep);
+
+	// Adds the real time elapsed since the last frame, returns the number of steps to run
+	int Advance(Duration elapsed);
+	// Adds the real time of an idle wait, returns its steps. None is dropped or kept as backlog: an idle
+	// state only counts time, its steps are cheap
+	int AdvanceIdle(Duration idle);
+	// Steps due but not run yet, backlog mode only
+	int GetBacklog() const;
+	// Takes up to count more steps of the backlog for this frame, returns how many
+	int TakeBacklog(int count);
+	// Fraction of a step left, to interpolate the presented frame
+	float GetInterpolation() const;
+	// False for the frames skipped by render decimation
+	bool ShouldRender() const;
+
+	int GetMaxSteps() const;          // per frame, at the current scale
+	int GetLastDroppedSteps() const;  // dropped by the last Advance
+	uint64 GetDroppedSteps() const;   // since Start
+	uint64 GetCappedFrames() const;   // frames that hit the cap since Start
+
+private:
+
+	void UpdateLimits();
+
+	Duration stepTime;
+	Duration accumTime;
+	double   stepsPerFrame;
+	float    scale;
+	float    decimationScale;
+	int      catchUpSteps;
+	bool     keepBacklog;
+	int      maxSteps;
+	int      renderInterval; // render one frame out of renderInterval
+	uint64   frameCount;
+	int      lastDroppedSteps;
+	uint64   droppedSteps;
+	uint64   cappedFrames;
+};
@@ -0,0 +1,91 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+SpatialGrid::SpatialGrid() :
+	invCellSize { 1.f },
+	cols { 0 },
+	rows { 0 }
+{}
+
+
+void SpatialGrid::Reset(const Vector2D& size, float cellSize)
+{
+	assert(cellSize > 0.f);
+	invCellSize = 1.f / cellSize;
+	cols = std::max(1, (int)std::ceil(size.x * invCellSize));
+	rows = std::max(1, (int)std::ceil(size.y * invCellSize));
+	cellStart.assign(cols * rows + 1, 0);
+	items.clear();
+	points.clear();
+}
+
+
+void SpatialGrid::Build(const Vector2D* positions, int count)
+{
+	assert(cols > 0 && rows > 0);
+	// Counting sort of the items by cell
+	std::fill(cellStart.begin(), cellStart.end(), 0);
+	itemCell.resize(count);
+	for (int i = 0; i < count; ++i)
+	{
+		const int cell = GetCellX(positions[i].x) + GetCellY(positions[i].y) * cols;
+		itemCell[i] = cell;
+		++cellStart[cell + 1];
+	}
+	for (int c = 0; c < cols * rows; ++c)
+	{
+		cellStart[c + 1] += cellStart[c];
+	}
+	items.resize(count);
+	points.resize(count);
+	for (int i = 0; i < count; ++i)
+	{
+		const int slot = cellStart[itemCell[i]]++;
+		items[slot] = i;
+		points[slot] = positions[i];
+	}
+	// The fill loop moved each start to the end of its cell, shift back
+	for (int c = cols * rows; c > 0; --c)
+	{
+		cellStart[c] = cellStart[c - 1];
+	}
+	cellStart[0] = 0;
+}
+
+
+void SpatialGrid::Query(const Vector2D& v0, const Vector2D& v1, std::vector<int>& out) const
+{
+	const int cx0 = GetCellX(v0.x);
+	const int cx1 = GetCellX(v1.x);
+	const int cy0 = GetCellY(v0.y);
+	const int cy1 = GetCellY(v1.y);
+	for (int cy = cy0; cy <= cy1; ++cy)
+	{
+		// Cells of a row are contiguous
+		const int begin = cellStart[cx0 + cy * cols];
+		const int end = cellStart[cx1 + cy * cols + 1];
+		for (int i = begin; i < end; ++i)
+		{
+			const Vector2D& p = points[i];
+			if (p.x >= v0.x && p.x <= v1.x && p.y >= v0.y && p.y <= v1.y)
+			{
+				out.push_back(items[i]);
+			}
+		}
+	}
+}
+
+
+int SpatialGrid::GetCellX(float x) const
+{
+	return std::max(0, std::min(cols - 1, (int)std::floor(x * invCellSize)));
+}
+
+
+int SpatialGrid::GetCellY(float y) const
+{
+	return std::max(0, std::min(rows - 1, (int)std::floor(y * invCellSize)));
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Vector2D.h"
+#include <vector>
+
+
+// Uniform grid of points. Items are bucketed by the cell of their position and stored cell by cell,
+// so a query only visits the items of the cells overlapping the query rectangle
+class SpatialGrid
+{
+public:
+
+	SpatialGrid();
+
+	// Covers [0, size). Points outside are clamped to the border cells
+	void Reset(const Vector2D& size, float cellSize);
+	void Build(const Vector2D* positions, int count);
+	// Appends to out the indices of the points inside [v0, v1]
+	void Query(const Vector2D& v0, const Vector2D& v1, std::vector<int>& out) const;
+
+private:
+
+	int GetCellX(float x) const;
+	int GetCellY(float y) const;
+
+	std::vector<int>      cellStart; // first item of each cell, one extra entry for the end of the last cell
+	std::vector<int>      items;     // item indices sorted by cell
+	std::vector<Vector2D> points;    // positions sorted by cell
+	std::vector<int>      itemCell;
+	float                 invCellSize;
+	int                   cols;
+	int                   rows;
+};
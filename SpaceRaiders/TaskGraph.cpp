@@ -0,0 +1,293 @@
+#include "TaskGraph.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+
+
+namespace
+{
+
+int CountBits(uint32 mask)
+{
+	int count = 0;
+	for (; mask; mask &= mask - 1)
+	{
+		++count;
+	}
+	return count;
+}
+
+int LowestBit(uint32 mask)
+{
+	assert(mask);
+	int bit = 0;
+	while (!(mask & BIT(bit)))
+	{
+		++bit;
+	}
+	return bit;
+}
+
+}
+
+
+TaskGraph::TaskGraph() :
+	taskTime {},
+	frameTaskTime {},
+	frameCriticalTime { 0. },
+	frameWallTime { 0. },
+	frameRuns { 0 },
+	lastTaskTime {},
+	lastCriticalTime { 0. },
+	lastCriticalPath {},
+	lastCriticalLength { 0 },
+	frameCount { 0 },
+	readyTasks { 0 },
+	waitingFor {},
+	doneTasks { 0 },
+	log { nullptr },
+	logHeader { false }
+{
+	tasks.reserve(maxTasks);
+}
+
+
+TaskGraph::~TaskGraph()
+{
+	if (log)
+	{
+		fclose(log);
+	}
+}
+
+
+int TaskGraph::Add(const char* name, Func func, TaskResources reads, TaskResources writes)
+{
+	assert((int)tasks.size() < maxTasks);
+	const int index = (int)tasks.size();
+	Task task { name, func, reads, writes, 0, 0 };
+	for (int i = 0; i < index; ++i)
+	{
+		Task& prev = tasks[i];
+		if ((prev.writes & (reads | writes)) || (prev.reads & writes))
+		{
+			task.predecessors |= BIT(i);
+			prev.successors |= BIT(index);
+		}
+	}
+	tasks.push_back(task);
+	return index;
+}
+
+
+int TaskGraph::GetNumTasks() const
+{
+	return (int)tasks.size();
+}
+
+
+const char* TaskGraph::GetName(int task) const
+{
+	return tasks[task].name;
+}
+
+
+uint32 TaskGraph::GetPredecessors(int task) const
+{
+	return tasks[task].predecessors;
+}
+
+
+void TaskGraph::Run(void* context, WorkerPool* pool)
+{
+	const int numTasks = (int)tasks.size();
+	runStart = Clock::now();
+	if (!pool || pool->GetNumThreads() == 1)
+	{
+		for (int t = 0; t < numTasks; ++t)
+		{
+			RunTask(t, context);
+		}
+	}
+	else
+	{
+		readyTasks = 0;
+		doneTasks = 0;
+		for (int t = 0; t < numTasks; ++t)
+		{
+			waitingFor[t] = CountBits(tasks[t].predecessors);
+			if (waitingFor[t] == 0)
+			{
+				readyTasks |= BIT(t);
+			}
+		}
+		// Every thread of the pool takes ready tasks until all are done
+		pool->ParallelFor(pool->GetNumThreads(), [this, context](int) { RunLane(context); });
+	}
+	frameWallTime += std::chrono::duration<double>(Clock::now() - runStart).count();
+
+	// Longest chain of dependent tasks of this run
+	double pathTime[maxTasks];
+	double criticalTime = 0.;
+	for (int t = 0; t < numTasks; ++t)
+	{
+		double start = 0.;
+		for (uint32 p = tasks[t].predecessors; p; p &= p - 1)
+		{
+			start = std::max(start, pathTime[LowestBit(p)]);
+		}
+		pathTime[t] = start + taskTime[t];
+		criticalTime = std::max(criticalTime, pathTime[t]);
+		frameTaskTime[t] += taskTime[t];
+	}
+	frameCriticalTime += criticalTime;
+	++frameRuns;
+}
+
+
+bool TaskGraph::StartLog(const char* fileName)
+{
+	if (log)
+	{
+		fclose(log);
+	}
+	log = fopen(fileName, "w");
+	logHeader = false;
+	return log != nullptr;
+}
+
+
+void TaskGraph::EndFrame()
+{
+	++frameCount;
+	if (frameRuns == 0)
+	{
+		return;
+	}
+	const int numTasks = (int)tasks.size();
+	// Critical path of the frame on the summed times, the tasks are in dependency order
+	double pathTime[maxTasks];
+	int pathPrev[maxTasks];
+	int last = -1;
+	for (int t = 0; t < numTasks; ++t)
+	{
+		double start = 0.;
+		pathPrev[t] = -1;
+		for (uint32 p = tasks[t].predecessors; p; p &= p - 1)
+		{
+			const int pred = LowestBit(p);
+			if (pathTime[pred] > start || pathPrev[t] < 0)
+			{
+				start = pathTime[pred];
+				pathPrev[t] = pred;
+			}
+		}
+		pathTime[t] = start + frameTaskTime[t];
+		if (last < 0 || pathTime[t] > pathTime[last])
+		{
+			last = t;
+		}
+	}
+	lastCriticalLength = 0;
+	for (int t = last; t >= 0; t = pathPrev[t])
+	{
+		lastCriticalPath[lastCriticalLength++] = t;
+	}
+	std::reverse(lastCriticalPath, lastCriticalPath + lastCriticalLength);
+	std::copy(frameTaskTime, frameTaskTime + numTasks, lastTaskTime);
+	lastCriticalTime = frameCriticalTime;
+
+	if (log)
+	{
+		WriteFrame();
+	}
+	std::fill(frameTaskTime, frameTaskTime + numTasks, 0.);
+	frameCriticalTime = 0.;
+	frameWallTime = 0.;
+	frameRuns = 0;
+}
+
+
+double TaskGraph::GetTaskTime(int task) const
+{
+	return lastTaskTime[task];
+}
+
+
+double TaskGraph::GetCriticalPathTime() const
+{
+	return lastCriticalTime;
+}
+
+
+int TaskGraph::GetCriticalPath(int* path) const
+{
+	std::copy(lastCriticalPath, lastCriticalPath + lastCriticalLength, path);
+	return lastCriticalLength;
+}
+
+
+void TaskGraph::RunTask(int task, void* context)
+{
+	PROFILE_ZONE(tasks[task].name);
+	const Clock::time_point start = Clock::now();
+	tasks[task].func(context);
+	taskTime[task] = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+
+void TaskGraph::RunLane(void* context)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		readyCv.wait(lock, [this] { return readyTasks != 0 || doneTasks == (int)tasks.size(); });
+		if (readyTasks == 0)
+		{
+			break;
+		}
+		// Lowest index first, the order of a sequential run
+		const int task = LowestBit(readyTasks);
+		readyTasks &= ~BIT(task);
+		lock.unlock();
+		RunTask(task, context);
+		lock.lock();
+		++doneTasks;
+		for (uint32 s = tasks[task].successors; s; s &= s - 1)
+		{
+			const int successor = LowestBit(s);
+			if (--waitingFor[successor] == 0)
+			{
+				readyTasks |= BIT(successor);
+			}
+		}
+		readyCv.notify_all();
+	}
+}
+
+
+void TaskGraph::WriteFrame()
+{
+	const int numTasks = (int)tasks.size();
+	if (!logHeader)
+	{
+		fprintf(log, "frame,runs,wall_us,critical_us,critical_path");
+		for (int t = 0; t < numTasks; ++t)
+		{
+			fprintf(log, ",%s_us", tasks[t].name);
+		}
+		fprintf(log, "\n");
+		logHeader = true;
+	}
+	fprintf(log, "%llu,%d,%.2f,%.2f,", (unsigned long long)frameCount, frameRuns, frameWallTime * 1e6, frameCriticalTime * 1e6);
+	for (int i = 0; i < lastCriticalLength; ++i)
+	{
+		fprintf(log, i ? ">%s" : "%s", tasks[lastCriticalPath[i]].name);
+	}
+	for (int t = 0; t < numTasks; ++t)
+	{
+		fprintf(log, ",%.2f", frameTaskTime[t] * 1e6);
+	}
+	fprintf(log, "\n");
+}
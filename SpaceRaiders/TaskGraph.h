@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Base.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+
+class WorkerPool;
+
+// One bit per resource, the users define their own
+typedef uint32 TaskResources;
+
+
+// Tasks with declared read and write sets. A task depends on the tasks added before it that write what
+// it reads or writes, or read what it writes, so a run has the result of running the tasks in order.
+// Independent tasks run concurrently on a worker pool. Task times are summed over the runs of a frame,
+// each frame can be logged with its critical path
+class TaskGraph
+{
+public:
+
+	typedef void (*Func)(void* context);
+
+	static constexpr int maxTasks = 32;
+
+	TaskGraph();
+	~TaskGraph();
+	TaskGraph(const TaskGraph&) = delete;
+	TaskGraph& operator=(const TaskGraph&) = delete;
+
+	// Returns the index of the task
+	int Add(const char* name, Func func, TaskResources reads, TaskResources writes);
+	int GetNumTasks() const;
+	const char* GetName(int task) const;
+	// Tasks the task waits for, one bit per task
+	uint32 GetPredecessors(int task) const;
+
+	// Runs all the tasks once. pool: nullptr or a single thread runs them in order on the caller
+	void Run(void* context, WorkerPool* pool);
+
+	// One line per frame with runs: time of every task, wall time and critical path. CSV
+	bool StartLog(const char* fileName);
+	// Closes the frame, writes it to the log and starts the next one
+	void EndFrame();
+
+	// Of the last frame with runs [s]
+	double GetTaskTime(int task) const;
+	double GetCriticalPathTime() const;
+	// Tasks of the critical path, in order
+	int GetCriticalPath(int* tasks) const;
+
+private:
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Task
+	{
+		const char*   name;
+		Func          func;
+		TaskResources reads;
+		TaskResources writes;
+		uint32        predecessors;
+		uint32        successors;
+	};
+
+	void RunTask(int task, void* context);
+	void RunLane(void* context);
+	void WriteFrame();
+
+	std::vector<Task>  tasks;
+	Clock::time_point  runStart;
+	double             taskTime[maxTasks];     // of the current run
+	// Current frame
+	double             frameTaskTime[maxTasks];
+	double             frameCriticalTime;      // sum over the runs
+	double             frameWallTime;
+	int                frameRuns;
+	// Last frame with runs
+	double             lastTaskTime[maxTasks];
+	double             lastCriticalTime;
+	int                lastCriticalPath[maxTasks];
+	int                lastCriticalLength;
+	uint64             frameCount;
+	// Parallel runs
+	std::mutex              mutex;
+	std::condition_variable readyCv;
+	uint32                  readyTasks;
+	int                     waitingFor[maxTasks]; // predecessors not done yet
+	int                     doneTasks;
+	FILE*                   log;
+	bool                    logHeader;
+};
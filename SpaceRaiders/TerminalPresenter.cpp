@@ -0,0 +1,277 @@
+#include "TerminalPresenter.h"
+#include "Profiler.h"
+#include <cassert>
+#include <cstring>
+
+
+namespace
+{
+
+using namespace CharAttribute;
+
+// Erasing a run of blanks costs two sequences (ECH + CUF), shorter runs are written as spaces
+constexpr int minEraseRun = 10;
+
+// Win32 attributes order the color bits BGR, ANSI colors RGB
+constexpr int ansiColor[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+
+int GetForegroundCode(uint16 attributes)
+{
+	const int base = (attributes & foregroundIntensity) ? 90 : 30;
+	return base + ansiColor[attributes & 7];
+}
+
+
+int GetBackgroundCode(uint16 attributes)
+{
+	const int base = (attributes & backgroundIntensity) ? 100 : 40;
+	return base + ansiColor[(attributes >> 4) & 7];
+}
+
+
+void AppendUInt(std::string& out, uint value)
+{
+	char tmp[16];
+	int n = 0;
+	do
+	{
+		tmp[n++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+	while (n)
+	{
+		out += tmp[--n];
+	}
+}
+
+
+bool IsBlank(const CharInfo& c, uint16 background)
+{
+	return c.ch == ' ' && (c.attributes & backgroundMask) == background;
+}
+
+}
+
+
+VTEncoder::VTEncoder()
+{
+	Reset();
+}
+
+
+void VTEncoder::Reset()
+{
+	prevFrame.clear();
+	prevCols = 0;
+	prevRows = 0;
+	curAttributes = 0;
+	validAttributes = false;
+}
+
+
+void VTEncoder::Encode(const CharInfo* canvas, int cols, int rows, std::string& out)
+{
+	assert(canvas);
+	const bool fullFrame = cols != prevCols || rows != prevRows;
+	int lastRow = -2; // last encoded row, the cursor is somewhere on it
+	for (int y = 0; y < rows; ++y)
+	{
+		const CharInfo* row = canvas + y * cols;
+		if (! fullFrame && ! memcmp(row, prevFrame.data() + y * cols, cols * sizeof(CharInfo)))
+		{
+			continue;
+		}
+		if (lastRow == y - 1)
+		{
+			out += "\r\n";
+		}
+		else
+		{
+			out += "\x1b[";
+			AppendUInt(out, y + 1);
+			out += ";1H";
+		}
+		EncodeRow(row, cols, out);
+		lastRow = y;
+	}
+	prevFrame.assign(canvas, canvas + cols * rows);
+	prevCols = cols;
+	prevRows = rows;
+}
+
+
+void VTEncoder::EncodeRow(const CharInfo* row, int cols, std::string& out)
+{
+	// Trailing blanks sharing the background of the last cell are erased with EL
+	const uint16 tailBackground = row[cols - 1].attributes & backgroundMask;
+	int end = cols;
+	while (end > 0 && IsBlank(row[end - 1], tailBackground))
+	{
+		--end;
+	}
+
+	int x = 0;
+	while (x < end)
+	{
+		const CharInfo& c = row[x];
+		if (c.ch == ' ')
+		{
+			// Blanks only need the right background, the foreground color is left as it is
+			const uint16 background = c.attributes & backgroundMask;
+			int n = 1;
+			while (x + n < end && IsBlank(row[x + n], background))
+			{
+				++n;
+			}
+			SetBackground(c.attributes, out);
+			if (n >= minEraseRun)
+			{
+				out += "\x1b[";
+				AppendUInt(out, n);
+				out += "X\x1b[";
+				AppendUInt(out, n);
+				out += 'C';
+			}
+			else
+			{
+				out.append(n, ' ');
+			}
+			x += n;
+		}
+		else
+		{
+			// Run of glyphs sharing the attributes, copied from the glyph table straight to the output
+			SetAttributes(c.attributes, out);
+			int n = 1;
+			while (x + n < end && row[x + n].ch != ' ' && row[x + n].attributes == c.attributes)
+			{
+				++n;
+			}
+			const size_t size = out.size();
+			out.resize(size + n * 3 + 1); // +1: glyphs are copied 4 bytes at a time
+			char* dst = &out[size];
+			for (int i = 0; i < n; ++i)
+			{
+				dst += CopyGlyphUTF8(row[x + i].ch, dst);
+			}
+			out.resize(dst - out.data());
+			x += n;
+		}
+	}
+	if (end < cols)
+	{
+		SetBackground(row[end].attributes, out);
+		out += "\x1b[K";
+	}
+}
+
+
+void VTEncoder::SetAttributes(uint16 attributes, std::string& out)
+{
+	attributes &= foregroundMask | backgroundMask;
+	if (validAttributes && attributes == curAttributes)
+	{
+		return;
+	}
+	out += "\x1b[";
+	if (! validAttributes)
+	{
+		out += "0;";
+		AppendUInt(out, GetForegroundCode(attributes));
+		out += ';';
+		AppendUInt(out, GetBackgroundCode(attributes));
+	}
+	else
+	{
+		const bool fgChanged = (attributes & foregroundMask) != (curAttributes & foregroundMask);
+		const bool bgChanged = (attributes & backgroundMask) != (curAttributes & backgroundMask);
+		if (fgChanged)
+		{
+			AppendUInt(out, GetForegroundCode(attributes));
+		}
+		if (bgChanged)
+		{
+			if (fgChanged)
+			{
+				out += ';';
+			}
+			AppendUInt(out, GetBackgroundCode(attributes));
+		}
+	}
+	out += 'm';
+	curAttributes = attributes;
+	validAttributes = true;
+}
+
+
+void VTEncoder::SetBackground(uint16 attributes, std::string& out)
+{
+	if (! validAttributes)
+	{
+		SetAttributes(attributes, out);
+	}
+	else
+	{
+		SetAttributes((curAttributes & foregroundMask) | (attributes & backgroundMask), out);
+	}
+}
+
+
+TerminalPresenter::TerminalPresenter(FILE* stream_) :
+	stream { stream_ },
+	frameCount { 0 },
+	totalBytes { 0 },
+	lastFrameBytes { 0 }
+{
+	assert(stream);
+}
+
+
+TerminalPresenter::~TerminalPresenter()
+{
+	if (frameCount)
+	{
+		fputs("\x1b[0m\x1b[?25h\r\n", stream);
+		fflush(stream);
+	}
+}
+
+
+void TerminalPresenter::Present(const CharInfo* canvas, int cols, int rows)
+{
+	PROFILE_ZONE("TerminalPresenter::Present");
+	output.clear();
+	if (frameCount == 0)
+	{
+		// Hide the cursor and clear the screen
+		output += "\x1b[?25l\x1b[2J";
+	}
+	encoder.Encode(canvas, cols, rows, output);
+	if (! output.empty())
+	{
+		fwrite(output.data(), 1, output.size(), stream);
+		fflush(stream);
+	}
+	lastFrameBytes = output.size();
+	totalBytes += lastFrameBytes;
+	++frameCount;
+}
+
+
+size_t TerminalPresenter::GetLastFrameBytes() const
+{
+	return lastFrameBytes;
+}
+
+
+double TerminalPresenter::GetAverageFrameBytes() const
+{
+	return frameCount ? (double)totalBytes / (double)frameCount : 0.;
+}
+
+
+uint64 TerminalPresenter::GetFrameCount() const
+{
+	return frameCount;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Base.h"
+#include "Presenter.h"
+#include "CharInfo.h"
+#include "GlyphTable.h"
+#include <vector>
+#include <string>
+#include <cstdio>
+
+
+// Encodes canvases as VT/ANSI escape sequences. The encoder tracks the attributes the terminal
+// currently has, so that an SGR sequence is emitted only when the color actually changes. Blank
+// cells only depend on the background color, runs of blanks are erased instead of written and
+// rows that did not change since the previous frame are skipped
+class VTEncoder
+{
+public:
+
+	VTEncoder();
+
+	// Forget the terminal state, the next frame is encoded in full
+	void Reset();
+	// Appends to out the sequences that turn the previous frame into this one
+	void Encode(const CharInfo* canvas, int cols, int rows, std::string& out);
+
+private:
+
+	void EncodeRow(const CharInfo* row, int cols, std::string& out);
+	void SetAttributes(uint16 attributes, std::string& out);
+	void SetBackground(uint16 attributes, std::string& out);
+
+	std::vector<CharInfo> prevFrame;
+	int                   prevCols;
+	int                   prevRows;
+	uint16                curAttributes;
+	bool                  validAttributes; // false if the terminal attributes are unknown
+};
+
+
+// Writes canvases to a VT compatible terminal
+class TerminalPresenter final : public Presenter
+{
+public:
+
+	explicit TerminalPresenter(FILE* stream);
+	// Restores the default attributes and shows the cursor
+	~TerminalPresenter();
+
+	void Present(const CharInfo* canvas, int cols, int rows) override;
+
+	// Output metrics
+	size_t GetLastFrameBytes() const;
+	double GetAverageFrameBytes() const;
+	uint64 GetFrameCount() const;
+
+private:
+
+	VTEncoder   encoder;
+	std::string output; // reused to avoid allocations
+	FILE*       stream;
+	uint64      frameCount;
+	uint64      totalBytes;
+	size_t      lastFrameBytes;
+};
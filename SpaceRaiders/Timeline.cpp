@@ -0,0 +1,149 @@
+#include "Timeline.h"
+#include "GameEvents.h"
+#include <algorithm>
+#include <cassert>
+
+
+Timeline::Timeline()
+{
+	Clear();
+}
+
+
+void Timeline::Clear()
+{
+	heap.clear();
+	waiting.clear();
+	live.clear();
+	time = 0.f;
+	nextSeq = 0;
+	nextId = 1;
+	numPending = 0;
+}
+
+
+float Timeline::GetTime() const
+{
+	return time;
+}
+
+
+TimelineId Timeline::ScheduleAt(const Event& event, float at)
+{
+	assert(event.repeat >= 0.f);
+	const TimelineId id = nextId++;
+	heap.push_back( { at, nextSeq++, id, event } );
+	std::push_heap(heap.begin(), heap.end(), Later());
+	const bool repeating = event.repeat > 0.f;
+	live.emplace(id, repeating);
+	numPending += repeating ? 0 : 1;
+	return id;
+}
+
+
+TimelineId Timeline::ScheduleIn(const Event& event, float delay)
+{
+	return ScheduleAt(event, time + delay);
+}
+
+
+float Timeline::ScheduleLevel(const Level& level)
+{
+	// Tables are in order: an event never fires before the previous one, so a wait delays all the
+	// events after it. Events sharing a time fire in the same tick
+	float prev = time;
+	for (int i = 0; i < level.numEvents; ++i)
+	{
+		const Event& event = level.events[i];
+		prev = event.timing == EventTiming::relative ? prev + event.time : std::max(time + event.time, prev);
+		ScheduleAt(event, prev);
+	}
+	return prev;
+}
+
+
+bool Timeline::Cancel(TimelineId id)
+{
+	const auto it = live.find(id);
+	if (it == live.end())
+	{
+		return false;
+	}
+	numPending -= it->second ? 0 : 1;
+	// The entry stays in the heap or in the waiting list until it comes up
+	live.erase(it);
+	return true;
+}
+
+
+void Timeline::Advance(float dt, Game& game, Handler handler)
+{
+	time += dt;
+
+	// Conditional events due in previous ticks come first
+	for (size_t i = 0; i < waiting.size(); )
+	{
+		Entry entry = waiting[i];
+		if (! live.count(entry.id) || entry.event.condition(game))
+		{
+			waiting.erase(waiting.begin() + i);
+			if (live.count(entry.id))
+			{
+				// A repeating event counts its period from now, not from the time it became due
+				entry.time = time;
+				Fire(entry, game, handler);
+			}
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	while (! heap.empty() && heap.front().time < time)
+	{
+		std::pop_heap(heap.begin(), heap.end(), Later());
+		Entry entry = heap.back();
+		heap.pop_back();
+		if (! live.count(entry.id))
+		{
+			continue;
+		}
+		if (entry.event.condition && ! entry.event.condition(game))
+		{
+			waiting.push_back(entry);
+			continue;
+		}
+		Fire(entry, game, handler);
+	}
+}
+
+
+int Timeline::GetNumPending() const
+{
+	return numPending;
+}
+
+
+void Timeline::Fire(Entry& entry, Game& game, Handler handler)
+{
+	handler(entry.event, game);
+	// The handler may have cancelled the event
+	const auto it = live.find(entry.id);
+	if (it == live.end())
+	{
+		return;
+	}
+	if (entry.event.repeat > 0.f)
+	{
+		entry.time += entry.event.repeat;
+		entry.seq = nextSeq++;
+		heap.push_back(entry);
+		std::push_heap(heap.begin(), heap.end(), Later());
+	}
+	else
+	{
+		live.erase(it);
+		--numPending;
+	}
+}
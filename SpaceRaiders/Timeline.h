@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Base.h"
+#include "Event.h"
+#include <vector>
+#include <unordered_map>
+
+
+struct Level;
+
+typedef uint32 TimelineId; // 0 is never a valid id
+
+
+// Events scheduled on a clock. Every event due in a tick fires in that tick, in time order and in
+// scheduling order for equal times. Scheduling is O(log n), cancelled events are skipped when they
+// come up
+class Timeline
+{
+public:
+
+	// Called for every due event
+	typedef void (*Handler)(const Event& event, Game& game);
+
+	Timeline();
+
+	// Cancels everything and sets the time back to 0
+	void Clear();
+	float GetTime() const;
+
+	// At an absolute time, or at once if the time is past. Event timing is ignored, repeat and
+	// condition are used
+	TimelineId ScheduleAt(const Event& event, float time);
+	// After a delay from the current time
+	TimelineId ScheduleIn(const Event& event, float delay);
+	// Schedules a level table, see EventTiming. Returns the time of the last event
+	float ScheduleLevel(const Level& level);
+	// False if the event already fired (and does not repeat) or was cancelled
+	bool Cancel(TimelineId id);
+
+	// Advances the time by dt and fires the events due, conditional events as soon as their condition
+	// is true. Handlers may schedule and cancel events
+	void Advance(float dt, Game& game, Handler handler);
+
+	// Events left to fire, repeating events excluded
+	int GetNumPending() const;
+
+private:
+
+	struct Entry
+	{
+		float      time;
+		uint32     seq;  // scheduling order, breaks ties
+		TimelineId id;
+		Event      event;
+	};
+
+	// Heap order: the earliest entry first
+	struct Later
+	{
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			return a.time > b.time || (a.time == b.time && a.seq > b.seq);
+		}
+	};
+
+	void Fire(Entry& entry, Game& game, Handler handler);
+
+	std::vector<Entry> heap;
+	std::vector<Entry> waiting; // due, waiting for their condition, in due order
+	// Scheduled events: id -> repeating. Entries whose id is missing were cancelled
+	std::unordered_map<TimelineId, bool> live;
+	float      time;
+	uint32     nextSeq;
+	TimelineId nextId;
+	int        numPending;
+};
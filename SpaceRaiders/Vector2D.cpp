@@ -1,6 +1,7 @@
 #include "Vector2D.h"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 
 
 Vector2D Lerp(const Vector2D& v0, const Vector2D& v1, float t)
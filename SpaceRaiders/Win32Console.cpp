@@ -57,6 +57,17 @@ bool ResizeConsole(void* handle, int cols, int rows, int fontSize)
 }
 
 
+bool EnableVirtualTerminal(void* handle)
+{
+	DWORD mode = 0;
+	if (!GetConsoleMode(handle, &mode))
+	{
+		return false;
+	}
+	return SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != 0;
+}
+
+
 namespace
 {
 
@@ -0,0 +1,114 @@
+#include "WorkerPool.h"
+#include "Profiler.h"
+#include <cassert>
+#include <algorithm>
+
+
+WorkerPool::WorkerPool(int numThreads) :
+	job { nullptr },
+	jobCount { 0 },
+	nextIndex { 0 },
+	busyWorkers { 0 },
+	generation { 0 },
+	quit { false }
+{
+	assert(numThreads >= 0);
+	if (numThreads == 0)
+	{
+		numThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	}
+	for (int i = 1; i < numThreads; ++i)
+	{
+		workers.emplace_back(&WorkerPool::WorkerLoop, this);
+	}
+}
+
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	startCv.notify_all();
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+
+int WorkerPool::GetNumThreads() const
+{
+	return (int)workers.size() + 1;
+}
+
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int)>& func)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	if (workers.empty() || count == 1)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			func(i);
+		}
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &func;
+		jobCount = count;
+		nextIndex = 0;
+		busyWorkers = (int)workers.size();
+		++generation;
+	}
+	startCv.notify_all();
+	RunJobs();
+	// Wait for the workers still running an index
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCv.wait(lock, [this] { return busyWorkers == 0; });
+	job = nullptr;
+}
+
+
+void WorkerPool::WorkerLoop()
+{
+	PROFILE_THREAD("Worker");
+	uint64 lastGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	for (;;)
+	{
+		startCv.wait(lock, [&] { return quit || generation != lastGeneration; });
+		if (quit)
+		{
+			break;
+		}
+		lastGeneration = generation;
+		lock.unlock();
+		RunJobs();
+		lock.lock();
+		if (--busyWorkers == 0)
+		{
+			doneCv.notify_one();
+		}
+	}
+}
+
+
+void WorkerPool::RunJobs()
+{
+	PROFILE_ZONE("WorkerPool::RunJobs");
+	for (;;)
+	{
+		const int index = nextIndex.fetch_add(1);
+		if (index >= jobCount)
+		{
+			break;
+		}
+		(*job)(index);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Base.h"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+
+// Fixed set of worker threads running parallel loops. The calling thread takes part in the work,
+// so a pool with one thread runs everything on the caller
+class WorkerPool
+{
+public:
+
+	// numThreads includes the calling thread. 0: one thread per hardware thread
+	explicit WorkerPool(int numThreads);
+	~WorkerPool();
+
+	int GetNumThreads() const;
+	// Calls func(index) for all the indices in [0, count) and waits until all calls are done
+	void ParallelFor(int count, const std::function<void(int)>& func);
+
+private:
+
+	void WorkerLoop();
+	void RunJobs();
+
+	std::vector<std::thread>          workers;
+	std::mutex                        mutex;
+	std::condition_variable           startCv;
+	std::condition_variable           doneCv;
+	const std::function<void(int)>*   job;
+	int                               jobCount;
+	std::atomic<int>                  nextIndex;
+	int                               busyWorkers;
+	uint64                            generation; // incremented for every job
+	bool                              quit;
+};